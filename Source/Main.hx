@@ -532,7 +532,8 @@ class Main extends Application {
 					return;
 				}
 
-				// Long-polling: blocks until messages available or timeout
+				// Long-polling: blocks until messages available or timeout. This holds the island thread
+				// (and a native worker, see extra_long_poll_workers) for the whole wait
 				var messages = messageBroker.getMessages(clientId, 30.0);
 
 				res.sendResponse(HTTPStatus.OK);
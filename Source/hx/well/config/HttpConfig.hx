@@ -8,4 +8,30 @@ class HttpConfig implements IConfig {
 	public var max_path_length:Int = 2048;
 	public var public_path:String = "static";
 	public var cache_path:String = "cache";
+
+	// CivetWeb server options (applied by CivetWebAdapter before start)
+	public var num_threads:Int = 16; // Worker threads; each in-flight request holds one. Raised by extra_long_poll_workers at start (logged)
+	public var listen_backlog:Int = 200;
+	public var request_timeout_ms:Int = 30000; // Socket read/write timeout
+	public var linger_timeout_ms:Int = -1; // -1 keeps the OS default
+	public var max_request_size:Int = 16384; // Request line + headers buffer
+	public var keep_alive:Bool = true;
+	public var keep_alive_timeout_ms:Int = 2000;
+	public var handler_timeout_ms:Int = 30000; // Answer 504 if a handler takes longer (override per route with @timeout)
+	public var native_island_dispatch:Bool = true; // CivetWeb routes requests to per-island native queues by session_id; islands poll them directly
+	public var max_queue_depth:Int = 256; // Unpolled requests before new ones get 503 + Retry-After (0 = unbounded)
+	public var extra_long_poll_workers:Int = 64; // Extra worker threads for long-polls: each waiting long-poll still holds one thread, so this caps concurrent long-polls (503 past it)
+	public var long_poll_paths:Array<String> = ["/poll/"]; // GET requests under these prefixes are suspended
+	public var long_poll_timeout_ms:Int = 35000; // Must exceed the broker's own long-poll wait
+	public var websocket_paths:Array<String> = ["/ws"]; // WebSocket endpoints; sub-paths are served too ("/ws/chat")
+	public var websocket_accept_timeout_ms:Int = 5000; // Handshakes the WebSocket handler has not accepted by then are refused
+	public var max_pending_websocket_handshakes:Int = 8; // Handshakes waiting for onConnect at once (each holds a worker); 503 past it
+	public var static_mounts:Array<{prefix:String, directory:String, ?cache_control:String}> = []; // Files served natively; other methods and missing files still reach Haxe
+	public var compression_min_size:Int = 1024; // Gzip dynamic responses at least this large (-1 disables; hdll needs USE_ZLIB)
+	public var compression_level:Int = 6; // zlib level: 1 fastest .. 9 smallest
+	public var compressible_types:Array<String> = null; // Content-Type prefixes to gzip (null keeps the native defaults: text/, JSON, JS, XML, SVG)
+	public var metrics_path:String = "/metrics"; // Prometheus scrape endpoint served by the adapter itself ("" disables)
+	public var native_trace_level:Int = 2; // Native events recorded for HybridLogger: 0 debug, 1 info, 2 warn, 3 error, 4 off
+	public var native_pool_limit:Int = 4 * 1024 * 1024; // Bytes per size class the native node pool keeps for reuse (process-wide; size from getPoolStats)
+	public var server_options:Map<String, String> = new Map(); // Any other CivetWeb option, passed through verbatim
 }
@@ -1,5 +1,6 @@
 package sidewinder.adapters;
 import sidewinder.interfaces.IWebSocketHandler.WebSocketOpcode;
+import sidewinder.interfaces.IWebSocketHandler.WebSocketConnectionId;
 import sidewinder.interfaces.IWebSocketServer;
 
 import sidewinder.routing.Router.UploadedFile;
@@ -23,11 +24,22 @@ import sidewinder.core.*;
 import sidewinder.native.CivetWebNative;
 import sidewinder.native.CivetWebNative.CivetWebRequest;
 import sidewinder.native.CivetWebNative.CivetWebResponse;
+import sidewinder.native.CivetWebNative.CivetWebRequestRecord;
+import sidewinder.native.CivetWebNative.CivetWebResponseStream;
+import sidewinder.native.CivetWebNative.CivetWebQueueStats;
+import sidewinder.native.CivetWebNative.CivetWebStageStats;
+import sidewinder.native.CivetWebNative.CivetWebPoolStats;
+import sidewinder.native.CivetWebNative.CivetWebWebSocketEvent;
+import sidewinder.native.CivetWebNative.CivetWebTraceEvent;
 
 
+import hx.well.config.ConfigData;
+import hx.well.config.HttpConfig;
+
 import haxe.io.Bytes;
 #if hl
 import hl.Bytes;
+import sidewinder.native.CivetWebNative.CivetWebResponseBatch;
 #end
 
 typedef SimpleResponse = {
@@ -35,6 +47,8 @@ typedef SimpleResponse = {
 	var contentType:String;
 	var body:String;
 	var headers:Map<String, String>;
+	/** Stream the body instead of sending `body` (see CivetWebResponseStream) */
+	var ?stream:CivetWebResponseStream->Void;
 };
 
 /**
@@ -47,6 +61,7 @@ typedef SimpleResponse = {
  * - CORS/OPTIONS support
  * - Multipart file upload support
  * - WebSocket support
+ * - Streamed (chunked) responses via SimpleResponse.stream
  * 
  * Requires: civetweb.hdll in Export/hl/bin/
  * To build: cd native/civetweb && make && make install
@@ -64,6 +79,23 @@ class CivetWebAdapter implements IWebServer implements IWebSocketServer {
 	private var sessionStore:Map<String, Float> = new Map();
 	private var pollCounter:Int = 0;
 	private var islandManager:IslandManager;
+	private static inline var MAX_REQUESTS_PER_POLL = 100;
+	private var requestRecords:hl.NativeArray<CivetWebRequestRecord>;
+	private var mainBatch:CivetWebResponseBatch;    // Answers given on the main loop, flushed once per handleRequest
+	private static inline var MAX_WS_EVENTS_PER_POLL = 100;
+	private var websocketEvents:hl.NativeArray<CivetWebWebSocketEvent>;
+	private var broadcastIds:hl.NativeArray<Int>;    // Reused by broadcast(), grown on demand
+	private static inline var MAX_TRACE_EVENTS_PER_DRAIN = 64;
+	private static inline var MAX_POOL_CLASSES = 16;
+	private var traceEvents:hl.NativeArray<CivetWebTraceEvent>;
+	private var nativeTraceLevel:Int = 2;
+	private var metricsPath:String = "/metrics";
+	private var longPollPaths:Array<String> = [];
+	private var longPollTimeoutMs:Int = 35000;
+	private var nativeIslandDispatch:Bool = true;
+	private static inline var MAX_REQUESTS_PER_ISLAND_POLL = 16;
+	private var islandRecords:Array<hl.NativeArray<CivetWebRequestRecord>> = null;  // One batch per island thread; set while islands poll natively
+	private var islandBatches:Array<CivetWebResponseBatch> = null;  // Responses of one pollIsland, pushed together
 
 	public function new(host:String, port:Int, ?documentRoot:String, ?handler:Router.Request->SimpleResponse, islandManager:IslandManager) {
 		this.host = host;
@@ -73,6 +105,18 @@ class CivetWebAdapter implements IWebServer implements IWebSocketServer {
 		this.documentRoot = documentRoot != null ? documentRoot : "./static";
 		this.requestHandler = handler;
 		this.islandManager = islandManager;
+		this.requestRecords = new hl.NativeArray<CivetWebRequestRecord>(MAX_REQUESTS_PER_POLL);
+		for (i in 0...MAX_REQUESTS_PER_POLL) {
+			requestRecords[i] = new CivetWebRequestRecord();
+		}
+		this.websocketEvents = new hl.NativeArray<CivetWebWebSocketEvent>(MAX_WS_EVENTS_PER_POLL);
+		for (i in 0...MAX_WS_EVENTS_PER_POLL) {
+			websocketEvents[i] = new CivetWebWebSocketEvent();
+		}
+		this.traceEvents = new hl.NativeArray<CivetWebTraceEvent>(MAX_TRACE_EVENTS_PER_DRAIN);
+		for (i in 0...MAX_TRACE_EVENTS_PER_DRAIN) {
+			traceEvents[i] = new CivetWebTraceEvent();
+		}
 
 		HybridLogger.info('[CivetWebAdapter] Initialized for $host:$port');
 		HybridLogger.info('[CivetWebAdapter] Document root: ${this.documentRoot}');
@@ -83,22 +127,236 @@ class CivetWebAdapter implements IWebServer implements IWebSocketServer {
 
 		try {
 			serverHandle = CivetWebNative.create(hostBytes, port, docRootBytes);
+			mainBatch = new CivetWebResponseBatch(serverHandle, MAX_REQUESTS_PER_POLL);
 			HybridLogger.info('[CivetWebAdapter] Native CivetWeb server created');
+			applyConfig(ConfigData.httpconfig);
 		} catch (e:Dynamic) {
 			HybridLogger.error('[CivetWebAdapter] Failed to create server: $e');
 			throw e;
 		}
 	}
 
+	/**
+	 * Apply server sizing from HttpConfig. Called from the constructor with ConfigData.httpconfig;
+	 * call again (before start()) to apply a different config.
+	 */
+	public function applyConfig(config:HttpConfig):Void {
+		if (config == null) return;
+		setOption("num_threads", Std.string(config.num_threads));
+		setOption("listen_backlog", Std.string(config.listen_backlog));
+		setOption("request_timeout_ms", Std.string(config.request_timeout_ms));
+		if (config.linger_timeout_ms >= 0) setOption("linger_timeout_ms", Std.string(config.linger_timeout_ms));
+		setOption("max_request_size", Std.string(config.max_request_size));
+		setKeepAlive(config.keep_alive, config.keep_alive_timeout_ms);
+		if (serverHandle != null && !running) CivetWebNative.setMaxBodySize(serverHandle, config.max_content_length);
+		if (serverHandle != null && !running) CivetWebNative.setMaxSuspended(serverHandle, config.extra_long_poll_workers);
+		if (serverHandle != null && !running) CivetWebNative.setDefaultTimeout(serverHandle, config.handler_timeout_ms);
+		if (serverHandle != null && !running) CivetWebNative.setMaxQueueDepth(serverHandle, config.max_queue_depth);
+		if (config.long_poll_paths != null) longPollPaths = config.long_poll_paths.copy();
+		longPollTimeoutMs = config.long_poll_timeout_ms;
+		nativeTraceLevel = config.native_trace_level;
+		metricsPath = config.metrics_path;
+		if (!running) nativeIslandDispatch = config.native_island_dispatch;
+		CivetWebNative.setTraceLevel(nativeTraceLevel);
+		CivetWebNative.setPoolLimit(config.native_pool_limit);
+		if (serverHandle != null && !running) {
+			if (config.websocket_paths != null) {
+				for (path in config.websocket_paths) {
+					if (!CivetWebNative.addWebSocketPath(serverHandle, stringToUtf8(path))) HybridLogger.warn('[CivetWebAdapter] Invalid WebSocket path: $path');
+				}
+			}
+			CivetWebNative.setWebSocketAcceptTimeout(serverHandle, config.websocket_accept_timeout_ms);
+			CivetWebNative.setMaxPendingHandshakes(serverHandle, config.max_pending_websocket_handshakes);
+			CivetWebNative.setCompression(serverHandle, config.compression_min_size, config.compression_level);
+			if (config.compressible_types != null) {
+				for (type in config.compressible_types) {
+					if (!CivetWebNative.addCompressibleType(serverHandle, stringToUtf8(type))) HybridLogger.warn('[CivetWebAdapter] Invalid compressible type: $type');
+				}
+			}
+			if (config.static_mounts != null) {
+				for (mount in config.static_mounts) {
+					addStaticMount(mount.prefix, mount.directory, mount.cache_control);
+				}
+			}
+		}
+		if (config.server_options != null) {
+			for (name in config.server_options.keys()) {
+				setOption(name, config.server_options.get(name));
+			}
+		}
+	}
+
+	/**
+	 * Set a CivetWeb option by name (e.g. "num_threads", "listen_backlog"). Must be called before start().
+	 * @return False if the server is running or CivetWeb does not recognize the option
+	 */
+	public function setOption(name:String, value:String):Bool {
+		if (running || serverHandle == null) {
+			HybridLogger.warn('[CivetWebAdapter] setOption($name) ignored - server already running');
+			return false;
+		}
+		var ok = CivetWebNative.setOption(serverHandle, stringToUtf8(name), stringToUtf8(value));
+		if (!ok) HybridLogger.warn('[CivetWebAdapter] Unknown CivetWeb option: $name');
+		return ok;
+	}
+
+	/**
+	 * Configure HTTP keep-alive. Must be called before start().
+	 * Each idle persistent connection holds a CivetWeb worker thread until the idle timeout expires.
+	 * @param enabled Honor persistent connections (default: true)
+	 * @param idleTimeoutMs Idle time before a persistent connection is closed (default: 2000)
+	 */
+	public function setKeepAlive(enabled:Bool, idleTimeoutMs:Int = 2000):Void {
+		if (running) {
+			HybridLogger.warn('[CivetWebAdapter] setKeepAlive ignored - server already running');
+			return;
+		}
+		if (serverHandle != null) {
+			CivetWebNative.setKeepAlive(serverHandle, enabled, idleTimeoutMs);
+		}
+	}
+
+	/**
+	 * Park a request that will be held open (e.g. a long-poll) for up to timeoutMs. A parked request still
+	 * holds its worker thread; it is counted against the extra long-poll workers rather than num_threads.
+	 * @return False if the request is gone or all extra_long_poll_workers are already taken
+	 */
+	public function suspendRequest(requestId:Int, timeoutMs:Int):Bool {
+		if (serverHandle == null) return false;
+		return CivetWebNative.suspendRequest(serverHandle, requestId, timeoutMs);
+	}
+
+	/**
+	 * Current request queue metrics (depth, high-water mark, rejected count, oldest entry age), e.g. for autoscaling.
+	 */
+	public function getQueueStats():CivetWebQueueStats {
+		var stats = new CivetWebQueueStats();
+		if (serverHandle != null) CivetWebNative.getQueueStats(serverHandle, stats);
+		return stats;
+	}
+
+	/**
+	 * Latency per request stage, keyed by CivetWebStageStats.STAGES name. Compare queue_wait and
+	 * poll_interval (main loop too slow to poll), processing (islands) and write (socket) to find
+	 * the bottleneck. Pass reset=true to start a new measurement interval.
+	 */
+	public function getLatencyStats(reset:Bool = false):Map<String, CivetWebStageStats> {
+		var result = new Map<String, CivetWebStageStats>();
+		if (serverHandle == null) return result;
+		var stages = new hl.NativeArray<CivetWebStageStats>(CivetWebStageStats.STAGES.length);
+		for (i in 0...stages.length) {
+			stages[i] = new CivetWebStageStats();
+		}
+		var count = CivetWebNative.getStats(serverHandle, stages, reset);
+		for (i in 0...count) {
+			result.set(CivetWebStageStats.STAGES[i], stages[i]);
+		}
+		return result;
+	}
+
+	/**
+	 * Native node pool usage per size class (smallest first, then blocks too large to pool), for sizing
+	 * HttpConfig.native_pool_limit from the high-water marks. The pool is shared by every server in the process.
+	 */
+	public function getPoolStats():Array<CivetWebPoolStats> {
+		var classes = new hl.NativeArray<CivetWebPoolStats>(MAX_POOL_CLASSES);
+		for (i in 0...classes.length) {
+			classes[i] = new CivetWebPoolStats();
+		}
+		var count = CivetWebNative.getPoolStats(classes);
+		return [for (i in 0...count) classes[i]];
+	}
+
+	/**
+	 * CivetWeb's server statistics (memory, connections, queue, requests, data, time), parsed from
+	 * its JSON. Null when the server is not running or civetweb.hdll lacks USE_SERVER_STATS.
+	 */
+	public function getContextInfo():Dynamic {
+		if (serverHandle == null || !running) return null;
+		var json = CivetWebNative.getContextInfo(serverHandle);
+		if (json == null) return null;
+		try {
+			return haxe.Json.parse(bytesToString(json));
+		} catch (e:Dynamic) {
+			HybridLogger.warn('[CivetWebAdapter] Unreadable CivetWeb context info: $e');
+			return null;
+		}
+	}
+
+	/**
+	 * One entry per worker thread: state, remote address, current request, connection age and bytes.
+	 * Entries CivetWeb could not render as valid JSON (e.g. a URI containing quotes) are skipped.
+	 */
+	public function getConnectionInfo():Array<Dynamic> {
+		var result:Array<Dynamic> = [];
+		if (serverHandle == null || !running) return result;
+		var index = 0;
+		var json = CivetWebNative.getConnectionInfo(serverHandle, index);
+		while (json != null) {
+			try {
+				result.push(haxe.Json.parse(bytesToString(json)));
+			} catch (e:Dynamic) {}
+			index++;
+			json = CivetWebNative.getConnectionInfo(serverHandle, index);
+		}
+		return result;
+	}
+
+	/**
+	 * Serve `directory` under the URI prefix `prefix` straight from the native layer: weak ETags,
+	 * Last-Modified, If-None-Match/If-Modified-Since revalidation and sendfile, with `cacheControl`
+	 * (e.g. "public, max-age=31536000, immutable") on every response. The longest matching prefix
+	 * wins; a directory path serves its index.html. Non-GET/HEAD requests and paths with no file
+	 * still reach Haxe. Must be called before start().
+	 */
+	public function addStaticMount(prefix:String, directory:String, ?cacheControl:String):Bool {
+		if (serverHandle == null || running) {
+			HybridLogger.warn('[CivetWebAdapter] addStaticMount($prefix) ignored - server already running');
+			return false;
+		}
+		var ok = CivetWebNative.addStaticMount(serverHandle, stringToUtf8(prefix), stringToUtf8(directory),
+			cacheControl != null ? stringToUtf8(cacheControl) : null);
+		if (!ok) HybridLogger.warn('[CivetWebAdapter] Invalid static mount: $prefix -> $directory');
+		return ok;
+	}
+
+	/**
+	 * Hand route timeouts (Router.add timeoutMs / AutoRouter @timeout) to the native layer, which enforces them
+	 * and turns requests away up front when the queue ahead of them cannot drain in time.
+	 * Every route is registered so native matching follows Router.find order exactly.
+	 */
+	private function registerRouteTimeouts(router:Router):Void {
+		var hasTimeouts = false;
+		for (route in router.routes) {
+			if (route.timeoutMs > 0) {
+				hasTimeouts = true;
+				break;
+			}
+		}
+		if (!hasTimeouts) return;
+		for (route in router.routes) {
+			CivetWebNative.setRouteTimeout(serverHandle, stringToUtf8(route.method), stringToUtf8(route.pattern), route.timeoutMs);
+		}
+	}
+
 	public function start():Void {
 		if (!running && serverHandle != null) {
 			try {
+				registerRouteTimeouts(Router.instance);
+				var islandCount = nativeIslandDispatch && islandManager != null ? islandManager.getIslandCount() : 0;
+				if (!CivetWebNative.setIslands(serverHandle, islandCount)) islandCount = 0;
 				var started = CivetWebNative.start(serverHandle);
 				if (started) {
 					running = true;
 					HybridLogger.info('[CivetWebAdapter] Server started on $host:$port');
 					HybridLogger.info('[CivetWebAdapter] Access at http://$host:$port');
-					HybridLogger.info('[CivetWebAdapter] Using polling architecture - call handleRequest() in main loop');
+					HybridLogger.info('[CivetWebAdapter] Up to ${CivetWebNative.getWorkerThreads(serverHandle)} worker threads (num_threads plus extra_long_poll_workers)');
+					if (islandCount > 0) {
+						attachIslands(islandCount);
+						HybridLogger.info('[CivetWebAdapter] Requests go straight to $islandCount island queues - call handleRequest() in main loop for WebSockets');
+					} else {
+						HybridLogger.info('[CivetWebAdapter] Using polling architecture - call handleRequest() in main loop');
+					}
 				} else {
 					HybridLogger.error('[CivetWebAdapter] Failed to start server');
 				}
@@ -114,68 +372,37 @@ class CivetWebAdapter implements IWebServer implements IWebSocketServer {
 			return;
 
 		try {
-			var maxRequests = 100;
 			var processed = 0;
 			pollCounter++;
 			if (pollCounter % 60 == 0) {
 				HybridLogger.debug('[CivetWebAdapter] Polling...');
 			}
 
-			while (processed < maxRequests) {
-				var req:Dynamic = null;
+			// With native island queues the islands poll for themselves; only WebSockets and tracing run here
+			var batchSize = 0;
+			if (islandRecords == null) {
 				try {
-					req = CivetWebNative.pollRequest(serverHandle);
+					batchSize = CivetWebNative.pollRequests(serverHandle, requestRecords, MAX_REQUESTS_PER_POLL);
 				} catch (e:Dynamic) {
-					HybridLogger.error('[CivetWebAdapter] pollRequest threw: ' + e + '\n' + haxe.CallStack.toString(haxe.CallStack.exceptionStack()));
+					HybridLogger.error('[CivetWebAdapter] pollRequests threw: ' + e + '\n' + haxe.CallStack.toString(haxe.CallStack.exceptionStack()));
 					throw e;
 				}
+			}
 
-				if (req == null)
-					break;
-
-				var requestId:Int = untyped req.id;
+			while (processed < batchSize) {
+				var req = requestRecords[processed];
+				var requestId = req.id;
 				processed++;
 
 				try {
-					var uriBytes:hl.Bytes = untyped req.uri;
-					var methodBytes:hl.Bytes = untyped req.method;
-					var bodyBytes:hl.Bytes = untyped req.body;
-					var queryStringBytes:hl.Bytes = untyped req.queryString;
-					var remoteAddrBytes:hl.Bytes = untyped req.remoteAddr;
-					var headersBytes:hl.Bytes = untyped req.headers;
-					var bodyLength:Int = untyped req.bodyLength;
-
-					var civetReq:CivetWebRequest = {
-						uri: bytesToString(uriBytes),
-						method: bytesToString(methodBytes),
-						body: bytesToStringWithLen(bodyBytes, bodyLength),
-						bodyLength: bodyLength,
-						queryString: bytesToString(queryStringBytes),
-						remoteAddr: bytesToString(remoteAddrBytes),
-						headers: bytesToString(headersBytes)
-					};
+					var civetReq = acceptRecord(req, mainBatch);
+					if (civetReq == null) continue;
 
 					var sessionId:Null<String> = null;
-					var cookies = parseCookies(bytesToString(headersBytes));
+					var cookies = parseCookies(civetReq.headers);
 					sessionId = cookies.get("session_id");
 
-					islandManager.dispatch(sessionId, () -> {
-						try {
-							var response = handleNativeRequest(civetReq);
-							var contentTypeBytes = stringToUtf8(response.contentType);
-							var bodyStr = response.body != null ? response.body : "";
-							var bodyBytesRef = haxe.io.Bytes.ofString(bodyStr);
-							var respBodyBytes = @:privateAccess bodyBytesRef.b;
-							CivetWebNative.pushResponse(serverHandle, requestId, response.statusCode, contentTypeBytes, respBodyBytes, bodyBytesRef.length);
-						} catch (e:Dynamic) {
-							HybridLogger.error('[CivetWebAdapter] Island processing error: $e');
-							var errorMsg = "Internal Server Error";
-							var errorBytes = haxe.io.Bytes.ofString(errorMsg);
-							var errorContentType = stringToUtf8("text/plain");
-							var errorBody = @:privateAccess errorBytes.b;
-							CivetWebNative.pushResponse(serverHandle, requestId, 500, errorContentType, errorBody, errorBytes.length);
-						}
-					});
+					islandManager.dispatch(sessionId, () -> respond(requestId, civetReq));
 				} catch (e:Dynamic) {
 					HybridLogger.error('[CivetWebAdapter] Error dispatching request: $e');
 				}
@@ -183,51 +410,232 @@ class CivetWebAdapter implements IWebServer implements IWebSocketServer {
 		} catch (e:Dynamic) {
 			HybridLogger.error('[CivetWebAdapter] Error in polling loop: $e\n' + haxe.CallStack.toString(haxe.CallStack.exceptionStack()));
 		}
-		if (websocketHandler != null) {
-			var maxWsEvents = 100;
-			var wsProcessed = 0;
-			while (wsProcessed < maxWsEvents) {
-				var evt:Dynamic = null;
-				try {
-					evt = CivetWebNative.pollWebSocketEvent(serverHandle);
-				} catch (e:Dynamic) {
-					HybridLogger.error('[CivetWebAdapter] pollWebSocketEvent threw: ' + e);
-					break;
+		mainBatch.flush();
+		// Drained even without a handler: upgrading workers wait on the CONNECT answer
+		var wsCount = 0;
+		try {
+			wsCount = CivetWebNative.pollWebSocketEvents(serverHandle, websocketEvents, MAX_WS_EVENTS_PER_POLL);
+		} catch (e:Dynamic) {
+			HybridLogger.error('[CivetWebAdapter] pollWebSocketEvents threw: ' + e);
+		}
+		for (i in 0...wsCount) {
+			var evt = websocketEvents[i];
+			try {
+				if (websocketHandler == null) {
+					// Nothing to hand the socket to: refuse the handshake right away
+					if (evt.type == 0) CivetWebNative.websocketAccept(serverHandle, evt.connId, false);
+					continue;
 				}
-				if (evt == null)
-					break;
-				wsProcessed++;
-				try {
-					switch (evt.type) {
-						case 0: 
-							// CivetWeb native doesn't currently expose the full handshake request in poll_websocket_event.
-							// Providing a minimal request object for compatibility.
-							var dummyReq:sidewinder.routing.Router.Request = {
-								method: "GET",
-								path: "/ws",
-								headers: new Map<String, String>(),
-								query: new Map<String, String>(),
-								params: new Map<String, String>(),
-								body: "",
-								rawBodyBytes: null,
-								jsonBody: null,
-								formBody: new Map<String, String>(),
-								cookies: new Map<String, String>(),
-								files: [],
-								ip: "0.0.0.0"
-							};
-							websocketHandler.onConnect(dummyReq);
-						case 1: websocketHandler.onReady(evt.conn);
-						case 2:
-							var dataBytes:hl.Bytes = evt.data;
-							websocketHandler.onData(evt.conn, evt.flags, dataBytes, evt.dataLength);
-						case 3: websocketHandler.onClose(evt.conn);
-					}
-				} catch (e:Dynamic) {
-					HybridLogger.error('[CivetWebAdapter] Error handling WebSocket event: ' + e);
+				switch (evt.type) {
+					case 0:
+						// The upgrading worker blocks until we answer; a throwing handler counts as a rejection
+						var accepted = false;
+						try {
+							accepted = websocketHandler.onConnect(evt.connId, parseHandshake(evt.data));
+						} catch (e:Dynamic) {
+							HybridLogger.error('[CivetWebAdapter] WebSocket onConnect threw: ' + e);
+						}
+						if (!CivetWebNative.websocketAccept(serverHandle, evt.connId, accepted) && accepted) {
+							HybridLogger.warn('[CivetWebAdapter] WebSocket handshake ${evt.connId} timed out before it was accepted');
+						}
+					case 1: websocketHandler.onReady(evt.connId);
+					case 2:
+						websocketHandler.onData(evt.connId, evt.flags, evt.data, evt.dataLength);
+					case 3: websocketHandler.onClose(evt.connId);
+				}
+			} catch (e:Dynamic) {
+				HybridLogger.error('[CivetWebAdapter] Error handling WebSocket event: ' + e);
+			}
+		}
+		if (nativeTraceLevel < 4) drainNativeTrace();
+	}
+
+	/**
+	 * Sleep for up to `timeoutMs` until there is something for handleRequest to do (a request on the
+	 * shared queue or a WebSocket event), so a dedicated main loop idles without spinning:
+	 * `while (running) { adapter.waitForWork(100); adapter.handleRequest(); }`. Returns false on timeout.
+	 */
+	public function waitForWork(timeoutMs:Int):Bool {
+		if (!running || serverHandle == null) return false;
+		return CivetWebNative.waitForWork(serverHandle, timeoutMs);
+	}
+
+	/**
+	 * Descriptor that becomes readable when waitForWork would return true, for hosts that poll their own
+	 * descriptors; after it fires, call waitForWork(0) and then handleRequest. Call before start; -1 if unsupported.
+	 */
+	public function getWakeupFd():Int {
+		if (serverHandle == null) return -1;
+		return CivetWebNative.getWakeupFd(serverHandle);
+	}
+
+	/**
+	 * Copy a polled record into a request. Metrics scrapes and long-polls that cannot be parked are
+	 * answered here (into `batch`); returns null for those.
+	 */
+	private function acceptRecord(req:CivetWebRequestRecord, batch:CivetWebResponseBatch):Null<CivetWebRequest> {
+		var requestId = req.id;
+		var bodyLength = req.bodyLength;
+		var civetReq:CivetWebRequest = {
+			uri: bytesToString(req.uri),
+			method: bytesToString(req.method),
+			body: bytesToStringWithLen(req.body, bodyLength),
+			bodyLength: bodyLength,
+			queryString: bytesToString(req.queryString),
+			remoteAddr: bytesToString(req.remoteAddr),
+			headers: bytesToString(req.headers)
+		};
+
+		if (metricsPath != null && metricsPath != "" && civetReq.uri == metricsPath && civetReq.method == "GET") {
+			// Answered before dispatch: scrapes must not queue behind the traffic they measure
+			var metricsBody = haxe.io.Bytes.ofString(CivetWebMetrics.render(this));
+			batch.add(requestId, 200, stringToUtf8(CivetWebMetrics.CONTENT_TYPE), null, @:privateAccess metricsBody.b, metricsBody.length);
+			return null;
+		}
+
+		if (isLongPoll(civetReq) && !suspendRequest(requestId, longPollTimeoutMs)) {
+			// Parking is full: turn the long-poll away rather than tie up a regular worker
+			var busyHeaders = new Map<String, String>();
+			busyHeaders.set("Retry-After", "1");
+			busyHeaders.set("Access-Control-Allow-Origin", "*");
+			var busyBody = haxe.io.Bytes.ofString("Too many pending long-poll requests");
+			batch.add(requestId, 503, stringToUtf8("text/plain"), stringToUtf8(formatHeaders(busyHeaders)), @:privateAccess busyBody.b,
+				busyBody.length);
+			return null;
+		}
+		return civetReq;
+	}
+
+	/**
+	 * Run the handler for a request and push its response (called on an island thread). With a
+	 * `batch` the response waits there for the caller's flush; otherwise it is pushed at once.
+	 */
+	private function respond(requestId:Int, civetReq:CivetWebRequest, ?batch:CivetWebResponseBatch):Void {
+		try {
+			var response = handleNativeRequest(civetReq);
+			if (response.stream != null) {
+				streamResponse(requestId, response);
+				return;
+			}
+			var contentTypeBytes = stringToUtf8(response.contentType);
+			var bodyStr = response.body != null ? response.body : "";
+			var bodyBytesRef = haxe.io.Bytes.ofString(bodyStr);
+			var respBodyBytes = @:privateAccess bodyBytesRef.b;
+			var headerBytes = stringToUtf8(formatHeaders(response.headers));
+			if (batch != null) {
+				batch.add(requestId, response.statusCode, contentTypeBytes, headerBytes, respBodyBytes, bodyBytesRef.length);
+			} else {
+				CivetWebNative.pushResponse(serverHandle, requestId, response.statusCode, contentTypeBytes, headerBytes, respBodyBytes,
+					bodyBytesRef.length);
+			}
+		} catch (e:Dynamic) {
+			HybridLogger.error('[CivetWebAdapter] Island processing error: $e');
+			var errorMsg = "Internal Server Error";
+			var errorBytes = haxe.io.Bytes.ofString(errorMsg);
+			var errorContentType = stringToUtf8("text/plain");
+			var errorBody = @:privateAccess errorBytes.b;
+			if (batch != null) {
+				batch.add(requestId, 500, errorContentType, null, errorBody, errorBytes.length);
+			} else {
+				CivetWebNative.pushResponse(serverHandle, requestId, 500, errorContentType, null, errorBody, errorBytes.length);
+			}
+		}
+	}
+
+	/**
+	 * Switch the islands to their native queues: each island thread blocks in pollIsland and answers
+	 * what CivetWeb routed to it, so requests never pass through the main loop.
+	 */
+	private function attachIslands(count:Int):Void {
+		var batches = [];
+		var responses = [];
+		for (i in 0...count) {
+			var records = new hl.NativeArray<CivetWebRequestRecord>(MAX_REQUESTS_PER_ISLAND_POLL);
+			for (j in 0...MAX_REQUESTS_PER_ISLAND_POLL) {
+				records[j] = new CivetWebRequestRecord();
+			}
+			batches.push(records);
+			responses.push(new CivetWebResponseBatch(serverHandle, MAX_REQUESTS_PER_ISLAND_POLL));
+		}
+		islandBatches = responses;
+		islandRecords = batches;
+		islandManager.attachFeed(pollIsland);
+	}
+
+	/**
+	 * IslandFeed: wait on this island's native queue and handle what arrives on the calling island thread.
+	 */
+	private function pollIsland(island:Int, timeoutMs:Int):Int {
+		var records = islandRecords != null ? islandRecords[island] : null;
+		if (records == null) return 0;
+		var batch = islandBatches[island];
+		var count = CivetWebNative.pollIsland(serverHandle, island, records, MAX_REQUESTS_PER_ISLAND_POLL, timeoutMs);
+		for (i in 0...count) {
+			var record = records[i];
+			var requestId = record.id;
+			try {
+				var civetReq = acceptRecord(record, batch);
+				if (civetReq != null) respond(requestId, civetReq, batch);
+			} catch (e:Dynamic) {
+				HybridLogger.error('[CivetWebAdapter] Error handling request $requestId on island $island: $e');
+			}
+		}
+		// Everything this poll answered goes back in one native call
+		batch.flush();
+		return count;
+	}
+
+	/**
+	 * Forward events buffered by the native layer to HybridLogger. handleRequest() calls this
+	 * every pass; call it directly to flush during startup or shutdown. Returns the number forwarded.
+	 */
+	public function drainNativeTrace():Int {
+		var total = 0;
+		var count = MAX_TRACE_EVENTS_PER_DRAIN;
+		while (count == MAX_TRACE_EVENTS_PER_DRAIN) {
+			count = CivetWebNative.drainTrace(traceEvents, MAX_TRACE_EVENTS_PER_DRAIN);
+			for (i in 0...count) {
+				var evt = traceEvents[i];
+				var age = evt.ageMs > 0 ? ' (${evt.ageMs}ms ago)' : '';
+				var msg = '[CivetWebNative] ' + bytesToString(evt.message) + age;
+				switch (evt.level) {
+					case 0: HybridLogger.debug(msg);
+					case 1: HybridLogger.info(msg);
+					case 2: HybridLogger.warn(msg);
+					default: HybridLogger.error(msg);
 				}
 			}
+			total += count;
+		}
+		return total;
+	}
+
+	/**
+	 * Send the status line and headers with chunked framing, then hand the open stream to the response's callback.
+	 * The callback may keep the stream and write to it later (e.g. server-sent events); it must call end().
+	 */
+	private function streamResponse(requestId:Int, response:CivetWebResponse):Void {
+		var started = CivetWebNative.beginResponse(serverHandle, requestId, response.statusCode, stringToUtf8(response.contentType),
+			stringToUtf8(formatHeaders(response.headers)));
+		if (!started) {
+			HybridLogger.warn('[CivetWebAdapter] Request $requestId no longer waiting - stream not started');
+			return;
+		}
+		var stream = new CivetWebResponseStream(serverHandle, requestId);
+		try {
+			response.stream(stream);
+		} catch (e:Dynamic) {
+			HybridLogger.error('[CivetWebAdapter] Stream handler error for request $requestId: $e');
+			stream.end();
+		}
+	}
+
+	private function isLongPoll(req:CivetWebRequest):Bool {
+		if (req.method != "GET") return false;
+		for (prefix in longPollPaths) {
+			if (StringTools.startsWith(req.uri, prefix)) return true;
 		}
+		return false;
 	}
 
 	private function stringToUtf8(s:String):hl.Bytes {
@@ -253,7 +661,11 @@ class CivetWebAdapter implements IWebServer implements IWebSocketServer {
 			var headers = parseHeaders(req.headers);
 			var pathOnly = req.uri.split("?")[0];
 			if (corsEnabled && req.method == "OPTIONS") {
-				return {statusCode: 200, contentType: "text/plain", body: "", bodyLength: 0};
+				var preflightHeaders = new Map<String, String>();
+				preflightHeaders.set("Access-Control-Allow-Origin", "*");
+				preflightHeaders.set("Access-Control-Allow-Methods", "GET, POST, PUT, DELETE, OPTIONS");
+				preflightHeaders.set("Access-Control-Allow-Headers", "Content-Type, Authorization");
+				return {statusCode: 200, contentType: "text/plain", body: "", bodyLength: 0, headers: preflightHeaders};
 			}
 			var contentType = headers.get("Content-Type");
 			if (contentType == null) contentType = headers.get("content-type");
@@ -308,7 +720,7 @@ class CivetWebAdapter implements IWebServer implements IWebSocketServer {
 			if (newSession) response.headers.set("Set-Cookie", 'session_id=$sessionId; Path=/; HttpOnly');
 			var respContentType = response.headers.get("Content-Type");
 			if (respContentType == null) respContentType = "text/html; charset=utf-8";
-			return {statusCode: response.statusCode, contentType: respContentType, body: response.body != null ? response.body : "", bodyLength: response.body != null ? response.body.length : 0};
+			return {statusCode: response.statusCode, contentType: respContentType, body: response.body != null ? response.body : "", bodyLength: response.body != null ? response.body.length : 0, headers: response.headers, stream: response.stream};
 		} catch (e:Dynamic) {
 			return {statusCode: 500, contentType: "text/plain", body: "Internal Server Error", bodyLength: 21};
 		}
@@ -326,6 +738,51 @@ class CivetWebAdapter implements IWebServer implements IWebSocketServer {
 		return result;
 	}
 
+	/**
+	 * Serialize response headers into the "Name: value\n" block expected by push_response.
+	 */
+	private function formatHeaders(headers:Map<String, String>):String {
+		if (headers == null) return "";
+		var buf = new StringBuf();
+		for (name in headers.keys()) {
+			var value = headers.get(name);
+			if (value == null) continue;
+			buf.add(name);
+			buf.add(": ");
+			buf.add(value);
+			buf.add("\n");
+		}
+		return buf.toString();
+	}
+
+	/**
+	 * Build the Request for a WebSocket connect event. The native handshake block holds the path,
+	 * query string and remote address on one line each, then "Name: value" header lines.
+	 */
+	private function parseHandshake(data:hl.Bytes):Router.Request {
+		var text = bytesToString(data);
+		var pathEnd = text.indexOf("\n");
+		var queryEnd = text.indexOf("\n", pathEnd + 1);
+		var addrEnd = text.indexOf("\n", queryEnd + 1);
+		var headers = parseHeaders(text.substr(addrEnd + 1));
+		var cookieHeader = headers.get("Cookie");
+		if (cookieHeader == null) cookieHeader = headers.get("cookie");
+		return {
+			method: "GET",
+			path: text.substring(0, pathEnd),
+			query: parseQueryString(text.substring(pathEnd + 1, queryEnd)),
+			headers: headers,
+			params: new Map<String, String>(),
+			body: "",
+			rawBodyBytes: null,
+			jsonBody: null,
+			formBody: new Map<String, String>(),
+			cookies: parseCookies(cookieHeader),
+			files: [],
+			ip: text.substring(queryEnd + 1, addrEnd)
+		};
+	}
+
 	private function parseQueryString(qs:String):Map<String, String> {
 		var result = new Map<String, String>();
 		if (qs == null || qs == "") return result;
@@ -355,8 +812,13 @@ class CivetWebAdapter implements IWebServer implements IWebSocketServer {
 	public function stop():Void {
 		if (running && serverHandle != null) {
 			try {
+				// Islands keep answering while CivetWeb drains its workers, then go back to dispatch()
 				CivetWebNative.stop(serverHandle);
 				running = false;
+				if (islandRecords != null) {
+					islandManager.attachFeed(null);
+					islandRecords = null;
+				}
 				HybridLogger.info('[CivetWebAdapter] Server stopped');
 			} catch (e:Dynamic) {}
 		}
@@ -366,31 +828,66 @@ class CivetWebAdapter implements IWebServer implements IWebSocketServer {
 	public function getPort():Int { return port; }
 	public function isRunning():Bool { return running; }
 	public function setWebSocketHandler(handler:IWebSocketHandler):Void { this.websocketHandler = handler; }
-	public function websocketSendText(conn:Dynamic, text:String):Void {
-		var bytes = stringToUtf8(text);
-		CivetWebNative.websocketSend(cast conn, WebSocketOpcode.TEXT, bytes, text.length);
+	public function websocketSendText(conn:WebSocketConnectionId, text:String):Void {
+		// Frame length is the UTF-8 byte count, not text.length
+		var bytes = haxe.io.Bytes.ofString(text);
+		CivetWebNative.websocketSend(serverHandle, conn, WebSocketOpcode.TEXT, @:privateAccess bytes.b, bytes.length);
 	}
-	public function websocketSendBinary(conn:Dynamic, data:haxe.io.Bytes):Void {
+	public function websocketSendBinary(conn:WebSocketConnectionId, data:haxe.io.Bytes):Void {
 		var hlBytes = @:privateAccess data.b;
-		CivetWebNative.websocketSend(cast conn, WebSocketOpcode.BINARY, hlBytes, data.length);
+		CivetWebNative.websocketSend(serverHandle, conn, WebSocketOpcode.BINARY, hlBytes, data.length);
 	}
-	public function websocketClose(conn:Dynamic, code:Int = 1000, ?reason:String):Void {
+	public function websocketClose(conn:WebSocketConnectionId, code:Int = 1000, ?reason:String):Void {
 		var reasonBytes = reason != null ? stringToUtf8(reason) : null;
-		CivetWebNative.websocketClose(cast conn, code, reasonBytes);
+		CivetWebNative.websocketClose(serverHandle, conn, code, reasonBytes);
+	}
+	public function websocketBroadcastText(conns:Array<WebSocketConnectionId>, text:String):Void {
+		var bytes = haxe.io.Bytes.ofString(text);
+		broadcast(conns, WebSocketOpcode.TEXT, @:privateAccess bytes.b, bytes.length);
+	}
+	public function websocketBroadcastBinary(conns:Array<WebSocketConnectionId>, data:haxe.io.Bytes):Void {
+		broadcast(conns, WebSocketOpcode.BINARY, @:privateAccess data.b, data.length);
+	}
+
+	/**
+	 * Hand the whole fan-out to native code in one call: the payload is converted and framed once.
+	 */
+	private function broadcast(conns:Array<WebSocketConnectionId>, opcode:Int, data:hl.Bytes, length:Int):Void {
+		if (conns.length == 0) return;
+		if (broadcastIds == null || broadcastIds.length < conns.length) {
+			broadcastIds = new hl.NativeArray<Int>(conns.length);
+		}
+		for (i in 0...conns.length) broadcastIds[i] = conns[i];
+		CivetWebNative.websocketBroadcast(serverHandle, broadcastIds, conns.length, opcode, data, length);
 	}
 }
 #else
 class CivetWebAdapter implements IWebServer implements IWebSocketServer {
 	public function new(host:String, port:Int, ?documentRoot:String, ?handler:Dynamic, islandManager:Dynamic) {}
 	public function start():Void {}
+	public function applyConfig(config:Dynamic):Void {}
+	public function setOption(name:String, value:String):Bool return false;
+	public function setKeepAlive(enabled:Bool, idleTimeoutMs:Int = 2000):Void {}
+	public function suspendRequest(requestId:Int, timeoutMs:Int):Bool return false;
+	public function addStaticMount(prefix:String, directory:String, ?cacheControl:String):Bool return false;
+	public function getQueueStats():Dynamic return null;
+	public function getLatencyStats(reset:Bool = false):Map<String, Dynamic> return new Map();
+	public function getPoolStats():Array<Dynamic> return [];
+	public function getContextInfo():Dynamic return null;
+	public function getConnectionInfo():Array<Dynamic> return [];
 	public function stop():Void {}
 	public function handleRequest():Void {}
+	public function waitForWork(timeoutMs:Int):Bool return false;
+	public function getWakeupFd():Int return -1;
+	public function drainNativeTrace():Int return 0;
 	public function getHost():String return "";
 	public function getPort():Int return 0;
 	public function isRunning():Bool return false;
 	public function setWebSocketHandler(handler:Dynamic):Void {}
-	public function websocketSendText(conn:Dynamic, text:String):Void {}
-	public function websocketSendBinary(conn:Dynamic, data:haxe.io.Bytes):Void {}
-	public function websocketClose(conn:Dynamic, code:Int = 1000, ?reason:String):Void {}
+	public function websocketSendText(conn:WebSocketConnectionId, text:String):Void {}
+	public function websocketSendBinary(conn:WebSocketConnectionId, data:haxe.io.Bytes):Void {}
+	public function websocketClose(conn:WebSocketConnectionId, code:Int = 1000, ?reason:String):Void {}
+	public function websocketBroadcastText(conns:Array<WebSocketConnectionId>, text:String):Void {}
+	public function websocketBroadcastBinary(conns:Array<WebSocketConnectionId>, data:haxe.io.Bytes):Void {}
 }
 #end
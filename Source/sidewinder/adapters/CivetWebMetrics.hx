@@ -0,0 +1,140 @@
+package sidewinder.adapters;
+
+#if hl
+import sidewinder.native.CivetWebNative.CivetWebStageStats;
+import sidewinder.native.CivetWebNative.CivetWebPoolStats;
+
+/**
+ * Renders CivetWebAdapter state in the Prometheus text exposition format (served at
+ * HttpConfig.metrics_path). Combines CivetWeb's own counters (needs USE_SERVER_STATS),
+ * per-worker connection state, the native request queue, the per-stage latency histograms and
+ * the native node pool.
+ */
+class CivetWebMetrics {
+	public static inline var CONTENT_TYPE = "text/plain; version=0.0.4; charset=utf-8";
+
+	/** Upper bounds, in seconds, of the connection age histogram */
+	private static var AGE_BUCKETS:Array<Float> = [1, 5, 15, 60, 300, 1800];
+
+	public static function render(adapter:CivetWebAdapter):String {
+		var out = new StringBuf();
+		renderContext(out, adapter.getContextInfo());
+		renderWorkers(out, adapter.getConnectionInfo());
+		renderQueue(out, adapter);
+		renderLatency(out, adapter.getLatencyStats());
+		renderPool(out, adapter.getPoolStats());
+		return out.toString();
+	}
+
+	private static function renderContext(out:StringBuf, info:Dynamic):Void {
+		if (info == null) {
+			out.add("# civetweb.hdll was built without USE_SERVER_STATS; server counters unavailable\n");
+			return;
+		}
+		if (info.connections != null) {
+			metric(out, "civetweb_connections_active", "gauge", "Client connections currently open", info.connections.active);
+			metric(out, "civetweb_connections_max_active", "gauge", "Most connections open at once since start", info.connections.maxActive);
+			metric(out, "civetweb_connections_total", "counter", "Connections accepted since start", info.connections.total);
+		}
+		if (info.queue != null) {
+			metric(out, "civetweb_accept_queue_length", "gauge", "Accepted sockets waiting for a free worker", info.queue.filled);
+			metric(out, "civetweb_accept_queue_max_length", "gauge", "Longest the accept queue has been", info.queue.maxFilled);
+			metric(out, "civetweb_accept_queue_capacity", "gauge", "Accept queue size", info.queue.length);
+		}
+		if (info.requests != null) {
+			metric(out, "civetweb_requests_total", "counter", "Requests handled since start", info.requests.total);
+		}
+		if (info.data != null) {
+			metric(out, "civetweb_received_bytes_total", "counter", "Bytes read from clients", info.data.read);
+			metric(out, "civetweb_sent_bytes_total", "counter", "Bytes written to clients", info.data.written);
+		}
+		if (info.memory != null) {
+			metric(out, "civetweb_memory_used_bytes", "gauge", "Memory allocated by CivetWeb", info.memory.used);
+		}
+		if (info.time != null) {
+			metric(out, "civetweb_uptime_seconds", "gauge", "Time since the server started", info.time.uptime);
+		}
+	}
+
+	private static function renderWorkers(out:StringBuf, workers:Array<Dynamic>):Void {
+		if (workers.length == 0) return;
+		var states = new Map<String, Int>();
+		var ages:Array<Float> = [];
+		for (worker in workers) {
+			var state:String = worker.state != null ? worker.state : "unknown";
+			states.set(state, (states.exists(state) ? states.get(state) : 0) + 1);
+			// Workers keep describing their last connection after it closes; only count open ones
+			if (worker.connection != null && worker.time != null && worker.time.closed == "") ages.push(worker.time.uptime);
+		}
+
+		header(out, "civetweb_workers", "gauge", "Worker threads by connection state (processing = running a request)");
+		for (state in states.keys()) {
+			out.add('civetweb_workers{state="$state"} ${states.get(state)}\n');
+		}
+
+		header(out, "civetweb_connection_age_seconds", "histogram", "Age of the connections workers are serving");
+		var sum = 0.0;
+		for (age in ages) sum += age;
+		for (bound in AGE_BUCKETS) {
+			var count = 0;
+			for (age in ages) if (age <= bound) count++;
+			out.add('civetweb_connection_age_seconds_bucket{le="$bound"} $count\n');
+		}
+		out.add('civetweb_connection_age_seconds_bucket{le="+Inf"} ${ages.length}\n');
+		out.add('civetweb_connection_age_seconds_sum $sum\n');
+		out.add('civetweb_connection_age_seconds_count ${ages.length}\n');
+	}
+
+	private static function renderQueue(out:StringBuf, adapter:CivetWebAdapter):Void {
+		var stats = adapter.getQueueStats();
+		metric(out, "sidewinder_request_queue_depth", "gauge", "Requests waiting for Haxe to poll them", stats.depth);
+		metric(out, "sidewinder_request_queue_max_depth", "gauge", "Queue depth at which requests are shed (0 = unbounded)", stats.maxDepth);
+		metric(out, "sidewinder_request_queue_oldest_age_seconds", "gauge", "Wait of the oldest queued request", stats.oldestAgeMs / 1000);
+		metric(out, "sidewinder_requests_rejected_total", "counter", "Requests answered 503 before reaching Haxe", stats.rejected);
+		metric(out, "sidewinder_websocket_events_dropped_total", "counter", "WebSocket events lost to a full event ring", stats.wsEventsDropped);
+	}
+
+	private static function renderLatency(out:StringBuf, stages:Map<String, CivetWebStageStats>):Void {
+		header(out, "sidewinder_request_stage_seconds", "summary", "Time requests spend in each native bridge stage");
+		for (stage in CivetWebStageStats.STAGES) {
+			var stats = stages.get(stage);
+			if (stats == null) continue;
+			var name = 'sidewinder_request_stage_seconds';
+			out.add('$name{stage="$stage",quantile="0.5"} ${stats.p50Us / 1e6}\n');
+			out.add('$name{stage="$stage",quantile="0.9"} ${stats.p90Us / 1e6}\n');
+			out.add('$name{stage="$stage",quantile="0.99"} ${stats.p99Us / 1e6}\n');
+			out.add('$name{stage="$stage",quantile="0.999"} ${stats.p999Us / 1e6}\n');
+			out.add('${name}_sum{stage="$stage"} ${stats.sumUs / 1e6}\n');
+			out.add('${name}_count{stage="$stage"} ${stats.count}\n');
+		}
+	}
+
+	private static function renderPool(out:StringBuf, classes:Array<CivetWebPoolStats>):Void {
+		if (classes.length == 0) return;
+		var series = [
+			{name: "sidewinder_pool_live_blocks", type: "gauge", help: "Native pool blocks allocated, in use or cached", value: (c:CivetWebPoolStats) -> (c.live:Float)},
+			{name: "sidewinder_pool_high_water_blocks", type: "gauge", help: "Most native pool blocks allocated at once", value: (c:CivetWebPoolStats) -> (c.highWater:Float)},
+			{name: "sidewinder_pool_cached_blocks", type: "gauge", help: "Free native pool blocks in the shared depot", value: (c:CivetWebPoolStats) -> (c.cached:Float)},
+			{name: "sidewinder_pool_mallocs_total", type: "counter", help: "Native pool misses that called malloc", value: (c:CivetWebPoolStats) -> c.mallocs}
+		];
+		for (s in series) {
+			header(out, s.name, s.type, s.help);
+			for (c in classes) {
+				var size = c.blockSize > 0 ? Std.string(c.blockSize) : "oversize";
+				out.add('${s.name}{block_size="$size"} ${s.value(c)}\n');
+			}
+		}
+	}
+
+	private static function header(out:StringBuf, name:String, type:String, help:String):Void {
+		out.add('# HELP $name $help\n');
+		out.add('# TYPE $name $type\n');
+	}
+
+	private static function metric(out:StringBuf, name:String, type:String, help:String, value:Dynamic):Void {
+		if (value == null) return;
+		header(out, name, type, help);
+		out.add('$name $value\n');
+	}
+}
+#end
@@ -16,6 +16,7 @@ import sidewinder.interfaces.IslandManager;
 import sidewinder.core.DI;
 import sidewinder.interfaces.IWebSocketHandler;
 import sidewinder.interfaces.IWebSocketHandler.WebSocketOpcode;
+import sidewinder.interfaces.IWebSocketHandler.WebSocketConnectionId;
 import sidewinder.logging.HybridLogger.LogLevel;
 import sidewinder.interfaces.IWebServer;
 import sidewinder.interfaces.IWebSocketServer;
@@ -52,6 +53,12 @@ class HxWellAdapter implements IWebServer implements IWebSocketServer {
 	var wsEventQueue:Array<WebSocketEvent> = [];
 	var wsMutex = new sys.thread.Mutex();
 
+	// Sessions by connection id, so handlers never hold a session past onClose
+	// (owned by the WebSocket event thread)
+	var wsSessions:Map<WebSocketConnectionId, WebSocketSession> = new Map();
+	var wsSessionIds:haxe.ds.ObjectMap<WebSocketSession, WebSocketConnectionId> = new haxe.ds.ObjectMap();
+	var nextWebSocketId:WebSocketConnectionId = 1;
+
 	public function new(host:String, port:Int, directory:String, islandManager:IslandManager) {
 		this.islandManager = islandManager;
 		this.host = host;
@@ -106,19 +113,34 @@ class HxWellAdapter implements IWebServer implements IWebSocketServer {
 				try {
 					switch (evt.type) {
 						case Connect(session, swReq):
-							if (!websocketHandler.onConnect(swReq)) {
+							var id = nextWebSocketId++;
+							wsSessions.set(id, session);
+							wsSessionIds.set(session, id);
+							if (!websocketHandler.onConnect(id, swReq)) {
 								HybridLogger.warn('[HxWellAdapter] WebSocket connection rejected by handler for session ${session.id}');
+								wsSessionIds.remove(session);
+								wsSessions.remove(id);
 								session.close();
 							}
 						case Open(session):
-							websocketHandler.onReady(session);
+							var id = wsSessionIds.get(session);
+							if (id == null) continue;
+							websocketHandler.onReady(id);
 						case Message(session, text):
+							var id = wsSessionIds.get(session);
+							if (id == null) continue;
 							var haxeBytes = haxe.io.Bytes.ofString(text);
-							websocketHandler.onData(session, WebSocketOpcode.TEXT, haxeBytes.getData(), haxeBytes.length);
+							websocketHandler.onData(id, WebSocketOpcode.TEXT, haxeBytes.getData(), haxeBytes.length);
 						case Binary(session, data):
-							websocketHandler.onData(session, WebSocketOpcode.BINARY, data.getData(), data.length);
+							var id = wsSessionIds.get(session);
+							if (id == null) continue;
+							websocketHandler.onData(id, WebSocketOpcode.BINARY, data.getData(), data.length);
 						case Close(session):
-							websocketHandler.onClose(session);
+							var id = wsSessionIds.get(session);
+							if (id == null) continue;
+							wsSessionIds.remove(session);
+							wsSessions.remove(id);
+							websocketHandler.onClose(id);
 					}
 				} catch (e:Dynamic) {
 					HybridLogger.error('[HxWellAdapter] WebSocket event processing error: ' + e);
@@ -630,19 +652,27 @@ class HxWellAdapter implements IWebServer implements IWebSocketServer {
 		HybridLogger.info('[HxWellAdapter] WebSocket handler registered');
 	}
 
-	public function websocketSendText(conn:Dynamic, text:String):Void {
-		var session:WebSocketSession = cast conn;
-		session.send(text);
+	public function websocketSendText(conn:WebSocketConnectionId, text:String):Void {
+		var session = wsSessions.get(conn);
+		if (session != null) session.send(text);
+	}
+
+	public function websocketSendBinary(conn:WebSocketConnectionId, data:haxe.io.Bytes):Void {
+		var session = wsSessions.get(conn);
+		if (session != null) session.sendBinary(data);
+	}
+
+	public function websocketClose(conn:WebSocketConnectionId, code:Int = 1000, ?reason:String):Void {
+		var session = wsSessions.get(conn);
+		if (session != null) session.close();
 	}
 
-	public function websocketSendBinary(conn:Dynamic, data:haxe.io.Bytes):Void {
-		var session:WebSocketSession = cast conn;
-		session.sendBinary(data);
+	public function websocketBroadcastText(conns:Array<WebSocketConnectionId>, text:String):Void {
+		for (conn in conns) websocketSendText(conn, text);
 	}
 
-	public function websocketClose(conn:Dynamic, code:Int = 1000, ?reason:String):Void {
-		var session:WebSocketSession = cast conn;
-		session.close();
+	public function websocketBroadcastBinary(conns:Array<WebSocketConnectionId>, data:haxe.io.Bytes):Void {
+		for (conn in conns) websocketSendBinary(conn, data);
 	}
 
 	public function pushWebSocketEvent(evt:WebSocketEvent):Void {
@@ -22,17 +22,17 @@ import sidewinder.routing.Router.Handler;
 class App {
   public static var router = sidewinder.routing.Router.instance;
 
-  public static function get(path:String, handler:Handler):Void
-    router.add("GET", path, handler);
+  public static function get(path:String, handler:Handler, timeoutMs:Int = 0):Void
+    router.add("GET", path, handler, timeoutMs);
 
-  public static function post(path:String, handler:Handler):Void
-    router.add("POST", path, handler);
+  public static function post(path:String, handler:Handler, timeoutMs:Int = 0):Void
+    router.add("POST", path, handler, timeoutMs);
 
-  public static function put(path:String, handler:Handler):Void
-    router.add("PUT", path, handler);
+  public static function put(path:String, handler:Handler, timeoutMs:Int = 0):Void
+    router.add("PUT", path, handler, timeoutMs);
 
-  public static function delete(path:String, handler:Handler):Void
-    router.add("DELETE", path, handler);
+  public static function delete(path:String, handler:Handler, timeoutMs:Int = 0):Void
+    router.add("DELETE", path, handler, timeoutMs);
 
   public static function use(mw:Middleware):Void
     router.use(mw);
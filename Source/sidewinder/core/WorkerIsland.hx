@@ -21,6 +21,10 @@ class WorkerIsland {
 	private var queueMutex:Mutex = new Mutex();
 	private var running:Bool = false;
 	private var processor:IslandRequest->Void;
+	private var feed:Null<IslandFeed> = null;
+
+	/** Longest a feed may block, so work enqueued here and stop() are still noticed promptly */
+	private static inline var FEED_WAIT_MS = 50;
 
 	public function new(id:Int, processor:IslandRequest->Void) {
 		this.id = id;
@@ -47,6 +51,13 @@ class WorkerIsland {
 					} catch (e:Dynamic) {
 						HybridLogger.error('[WorkerIsland $id] Error processing request: ' + e);
 					}
+				} else if (feed != null) {
+					// The feed blocks until it has work, so an idle island does not spin
+					try {
+						feed(id, FEED_WAIT_MS);
+					} catch (e:Dynamic) {
+						HybridLogger.error('[WorkerIsland $id] Error processing fed requests: ' + e);
+					}
 				} else {
 					// Sleep briefly to prevent tight loop when idle
 					#if !html5
@@ -61,6 +72,14 @@ class WorkerIsland {
 		running = false;
 	}
 
+	/**
+	 * Let this island pull work from outside its own queue (e.g. a native per-island request queue)
+	 * whenever that queue is empty. Pass null to go back to sleeping when idle.
+	 */
+	public function setFeed(feed:Null<IslandFeed>):Void {
+		this.feed = feed;
+	}
+
 	/**
 	 * Enqueue a request to be processed by this island.
 	 */
@@ -102,3 +121,9 @@ typedef IslandRequest = {
 	 */
 	var work:Void->Void;
 }
+
+/**
+ * Work source an island drains on its own thread: called with the island id and the longest it may
+ * block in milliseconds, it handles whatever arrives and returns how many requests it processed.
+ */
+typedef IslandFeed = (islandId:Int, timeoutMs:Int) -> Int;
@@ -7,38 +7,46 @@ import sidewinder.interfaces.IWebSocketHandler.WebSocketOpcode;
  */
 interface IWebSocketHandler {
     /**
-     * Called when a new WebSocket connection is established
-     * @param req The original HTTP request that requested the upgrade
-     * @return True to accept the connection, false to reject
+     * Called when a client requests the upgrade, before the handshake is answered
+     * @param conn Connection id, used again by onReady/onData/onClose if accepted
+     * @param req The original HTTP request that requested the upgrade (path, query, headers, cookies)
+     * @return True to accept the connection, false to refuse it before the upgrade
      */
-    function onConnect(req:sidewinder.routing.Router.Request):Bool;
+    function onConnect(conn:WebSocketConnectionId, req:sidewinder.routing.Router.Request):Bool;
     
     /**
      * Called when the WebSocket is ready to send/receive data
-     * @param conn Connection handle
+     * @param conn Connection id
      */
-    function onReady(conn:Dynamic):Void;
+    function onReady(conn:WebSocketConnectionId):Void;
     
     /**
      * Called when data is received from the WebSocket
-     * @param conn Connection handle
+     * @param conn Connection id
      * @param flags WebSocket flags (FIN, opcode, etc.)
      * @param data Data received
      * @param length Length of data
      */
 #if hl
-    function onData(conn:Dynamic, flags:Int, data:hl.Bytes, length:Int):Void;
+    function onData(conn:WebSocketConnectionId, flags:Int, data:hl.Bytes, length:Int):Void;
 #else
-    function onData(conn:Dynamic, flags:Int, data:haxe.io.Bytes, length:Int):Void;
+    function onData(conn:WebSocketConnectionId, flags:Int, data:haxe.io.Bytes, length:Int):Void;
 #end
     
     /**
      * Called when the WebSocket connection is closed
-     * @param conn Connection handle
+     * @param conn Connection id
      */
-    function onClose(conn:Dynamic):Void;
+    function onClose(conn:WebSocketConnectionId):Void;
 }
 
+/**
+ * Identifies a WebSocket connection for its whole lifetime. Ids increase monotonically and
+ * are not reused while the connection is open, so handlers can key maps by them; sending to
+ * an id after onClose is a no-op rather than a write to a recycled socket.
+ */
+typedef WebSocketConnectionId = Int;
+
 /**
  * WebSocket opcode constants
  */
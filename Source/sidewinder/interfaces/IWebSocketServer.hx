@@ -1,15 +1,23 @@
 package sidewinder.interfaces;
 
 import haxe.io.Bytes;
+import sidewinder.interfaces.IWebSocketHandler.WebSocketConnectionId;
 
 /**
  * Interface for web servers that support WebSockets.
  * Allows handlers to send data back to the client without being tied to a specific adapter.
+ * Sends and closes on a connection that has already closed are ignored.
  */
 interface IWebSocketServer {
 	function setWebSocketHandler(handler:IWebSocketHandler):Void;
-	function websocketSendText(conn:Dynamic, text:String):Void;
-	function websocketSendBinary(conn:Dynamic, data:Bytes):Void;
-	function websocketClose(conn:Dynamic, code:Int = 1000, ?reason:String):Void;
+	function websocketSendText(conn:WebSocketConnectionId, text:String):Void;
+	function websocketSendBinary(conn:WebSocketConnectionId, data:Bytes):Void;
+	function websocketClose(conn:WebSocketConnectionId, code:Int = 1000, ?reason:String):Void;
+
+	/**
+	 * Send the same message to many connections; cheaper than a websocketSendText per connection.
+	 */
+	function websocketBroadcastText(conns:Array<WebSocketConnectionId>, text:String):Void;
+	function websocketBroadcastBinary(conns:Array<WebSocketConnectionId>, data:Bytes):Void;
 }
 
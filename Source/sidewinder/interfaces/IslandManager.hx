@@ -3,6 +3,7 @@ package sidewinder.interfaces;
 import sidewinder.interfaces.User;
 import sidewinder.logging.HybridLogger;
 import sidewinder.core.WorkerIsland;
+import sidewinder.core.WorkerIsland.IslandFeed;
 import sys.thread.Thread;
 import haxe.crypto.Md5;
 
@@ -59,6 +60,17 @@ class IslandManager {
 		});
 	}
 
+	/**
+	 * Have every island pull requests from `feed` when its own queue is empty, bypassing dispatch.
+	 * The feed is responsible for stickiness (e.g. CivetWeb hashes session_id natively).
+	 * Pass null to detach it.
+	 */
+	public function attachFeed(feed:Null<IslandFeed>):Void {
+		for (island in islands) {
+			island.setFeed(feed);
+		}
+	}
+
 	/**
 	 * Stop all islands.
 	 */
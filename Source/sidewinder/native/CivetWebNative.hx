@@ -21,6 +21,97 @@ abstract CivetWebNative(hl.Abstract<"hl_civetweb_server">) {
 	@:hlNative("civetweb", "stop")
 	public static function stop(server:CivetWebNative):Void {}
 
+	/**
+	 * Set any CivetWeb option by name (must be called before start).
+	 * Returns false if CivetWeb does not recognize the option.
+	 */
+	@:hlNative("civetweb", "set_option")
+	public static function setOption(server:CivetWebNative, name:hl.Bytes, value:hl.Bytes):Bool {
+		return false;
+	}
+
+	/**
+	 * Cap request body size; larger requests are answered with 413 (must be called before start).
+	 */
+	@:hlNative("civetweb", "set_max_body_size")
+	public static function setMaxBodySize(server:CivetWebNative, maxBytes:Int):Void {}
+
+	/**
+	 * Enable or disable HTTP keep-alive and set the idle timeout (must be called before start).
+	 */
+	@:hlNative("civetweb", "set_keep_alive")
+	public static function setKeepAlive(server:CivetWebNative, enabled:Bool, idleTimeoutMs:Int):Void {}
+
+	/**
+	 * Set how many extra worker threads long-polls may hold, i.e. how many requests may be suspended
+	 * at once (must be called before start).
+	 */
+	@:hlNative("civetweb", "set_max_suspended")
+	public static function setMaxSuspended(server:CivetWebNative, maxSuspended:Int):Void {}
+
+	/**
+	 * Worker threads CivetWeb was started with: num_threads plus maxSuspended, one per parked request (0 before start).
+	 */
+	@:hlNative("civetweb", "get_worker_threads")
+	public static function getWorkerThreads(server:CivetWebNative):Int {
+		return 0;
+	}
+
+	/**
+	 * How long a request may wait for its response before the server answers 504 (must be called before start).
+	 */
+	@:hlNative("civetweb", "set_default_timeout")
+	public static function setDefaultTimeout(server:CivetWebNative, timeoutMs:Int):Void {}
+
+	/**
+	 * Timeout for requests matching a Router pattern, checked in registration order like Router.find
+	 * (must be called before start). 0 keeps the default timeout.
+	 */
+	@:hlNative("civetweb", "set_route_timeout")
+	public static function setRouteTimeout(server:CivetWebNative, method:hl.Bytes, pattern:hl.Bytes, timeoutMs:Int):Bool {
+		return false;
+	}
+
+	/**
+	 * Request queue high-water mark: past it, requests get 503 + Retry-After without reaching Haxe.
+	 * 0 removes the bound (must be called before start).
+	 */
+	@:hlNative("civetweb", "set_max_queue_depth")
+	public static function setMaxQueueDepth(server:CivetWebNative, maxDepth:Int):Void {}
+
+	/**
+	 * Snapshot request queue metrics into `stats`.
+	 */
+	@:hlNative("civetweb", "get_queue_stats")
+	public static function getQueueStats(server:CivetWebNative, stats:CivetWebQueueStats):Void {}
+
+	/**
+	 * Summarize the per-stage latency histograms into `stages`, in CivetWebStageStats.STAGES order.
+	 * With `reset` the histograms start over. Returns the number of records filled.
+	 */
+	@:hlNative("civetweb", "get_stats")
+	public static function getStats(server:CivetWebNative, stages:hl.NativeArray<CivetWebStageStats>, reset:Bool):Int {
+		return 0;
+	}
+
+	/**
+	 * CivetWeb's server statistics as JSON (connections, accept queue, requests, bytes, uptime).
+	 * Null unless civetweb.hdll was built with USE_SERVER_STATS.
+	 */
+	@:hlNative("civetweb", "get_context_info")
+	public static function getContextInfo(server:CivetWebNative):hl.Bytes {
+		return null;
+	}
+
+	/**
+	 * State of one worker thread and its connection as JSON; null past the last worker.
+	 * Needs USE_SERVER_STATS and MG_EXPERIMENTAL_INTERFACES.
+	 */
+	@:hlNative("civetweb", "get_connection_info")
+	public static function getConnectionInfo(server:CivetWebNative, index:Int):hl.Bytes {
+		return null;
+	}
+
 	@:hlNative("civetweb", "is_running")
 	public static function isRunning(server:CivetWebNative):Bool {
 		return false;
@@ -44,36 +135,279 @@ abstract CivetWebNative(hl.Abstract<"hl_civetweb_server">) {
 		return null;
 	}
 
+	/**
+	 * Drain up to `max` pending WebSocket events into the preallocated `events` in one native call.
+	 * Returns the number of events filled.
+	 */
+	@:hlNative("civetweb", "poll_websocket_events")
+	public static function pollWebSocketEvents(server:CivetWebNative, events:hl.NativeArray<CivetWebWebSocketEvent>, max:Int):Int {
+		return 0;
+	}
+
+	/**
+	 * Set the minimum level native code records (0 debug, 1 info, 2 warn, 3 error, 4 off).
+	 * Process-wide; applies to every server and thread immediately.
+	 */
+	@:hlNative("civetweb", "set_trace_level")
+	public static function setTraceLevel(level:Int):Void {}
+
+	/**
+	 * Drain up to `max` buffered native trace events into the preallocated `records`.
+	 * Returns the number of records filled.
+	 */
+	@:hlNative("civetweb", "drain_trace")
+	public static function drainTrace(records:hl.NativeArray<CivetWebTraceEvent>, max:Int):Int {
+		return 0;
+	}
+
+	/**
+	 * Node pool usage into the preallocated `classes`: one record per size class, smallest first,
+	 * then one for blocks too large to pool (blockSize 0). Process-wide. Returns the number filled.
+	 */
+	@:hlNative("civetweb", "get_pool_stats")
+	public static function getPoolStats(classes:hl.NativeArray<CivetWebPoolStats>):Int {
+		return 0;
+	}
+
+	/**
+	 * Bytes per size class the node pool keeps for reuse once freed; the rest goes back to malloc.
+	 * Process-wide.
+	 */
+	@:hlNative("civetweb", "set_pool_limit")
+	public static function setPoolLimit(bytes:Int):Void {}
+
+	/**
+	 * Send a frame to one of this server's connection ids. Returns -1 without sending once the
+	 * connection has closed. Ids are issued per server, so always pass the server that reported them.
+	 */
 	@:hlNative("civetweb", "websocket_send")
-	public static function websocketSend(conn:hl.Bytes, opcode:Int, data:hl.Bytes, length:Int):Int {
+	public static function websocketSend(server:CivetWebNative, connId:Int, opcode:Int, data:hl.Bytes, length:Int):Int {
 		return -1;
 	}
 
 	@:hlNative("civetweb", "websocket_close")
-	public static function websocketClose(conn:hl.Bytes, code:Int, reason:hl.Bytes):Void {}
+	public static function websocketClose(server:CivetWebNative, connId:Int, code:Int, reason:hl.Bytes):Void {}
+
+	/**
+	 * Answer a pending handshake (the connId of a connect event). The upgrading worker waits for
+	 * this; returns false if the handshake already timed out.
+	 */
+	@:hlNative("civetweb", "websocket_accept")
+	public static function websocketAccept(server:CivetWebNative, connId:Int, accept:Bool):Bool {
+		return false;
+	}
+
+	/**
+	 * Serve WebSockets under another path prefix; the first call replaces the default "/ws".
+	 * Must be called before start().
+	 */
+	@:hlNative("civetweb", "add_websocket_path")
+	public static function addWebSocketPath(server:CivetWebNative, path:hl.Bytes):Bool {
+		return false;
+	}
+
+	/**
+	 * Serve files under a URI prefix from a directory without involving Haxe (ETag, Last-Modified,
+	 * 304 revalidation, sendfile). `cacheControl` may be null. Must be called before start().
+	 */
+	@:hlNative("civetweb", "add_static_mount")
+	public static function addStaticMount(server:CivetWebNative, prefix:hl.Bytes, directory:hl.Bytes, cacheControl:hl.Bytes):Bool {
+		return false;
+	}
+
+	/**
+	 * Gzip buffered responses of at least `minSize` bytes (negative disables) at zlib `level` 1-9,
+	 * for clients sending Accept-Encoding: gzip. No effect unless the hdll was built with USE_ZLIB.
+	 * Must be called before start().
+	 */
+	@:hlNative("civetweb", "set_compression")
+	public static function setCompression(server:CivetWebNative, minSize:Int, level:Int):Void {}
 
+	/**
+	 * Compress responses whose Content-Type starts with `prefix`; the first call replaces the
+	 * defaults (text/, JSON, JavaScript, XML, SVG). Must be called before start().
+	 */
+	@:hlNative("civetweb", "add_compressible_type")
+	public static function addCompressibleType(server:CivetWebNative, prefix:hl.Bytes):Bool {
+		return false;
+	}
+
+	@:hlNative("civetweb", "set_websocket_accept_timeout")
+	public static function setWebSocketAcceptTimeout(server:CivetWebNative, timeoutMs:Int):Void {}
+
+	/**
+	 * Cap how many WebSocket handshakes may wait for `websocketAccept` at once (must be called before
+	 * start). Each holds a worker thread; upgrades past the cap get 503.
+	 */
+	@:hlNative("civetweb", "set_max_pending_handshakes")
+	public static function setMaxPendingHandshakes(server:CivetWebNative, maxPending:Int):Void {}
+
+	/**
+	 * Frame `data` once and write it to the first `count` connection ids in `connIds`.
+	 * Closed ids are skipped. Returns the number of connections written to.
+	 */
+	@:hlNative("civetweb", "websocket_broadcast")
+	public static function websocketBroadcast(server:CivetWebNative, connIds:hl.NativeArray<Int>, count:Int, opcode:Int, data:hl.Bytes, length:Int):Int {
+		return 0;
+	}
+
+	/**
+	 * Dequeue one request into `record`. Returns false when no requests are pending.
+	 */
 	@:hlNative("civetweb", "poll_request")
-	public static function pollRequest(server:CivetWebNative):Dynamic {
-		return null;
+	public static function pollRequest(server:CivetWebNative, record:CivetWebRequestRecord):Bool {
+		return false;
 	}
 
+	/**
+	 * Complete a request. `headers` is an optional "Name: value\n" block written to the wire as-is
+	 * (Content-Length, Connection and Transfer-Encoding are managed natively).
+	 */
 	@:hlNative("civetweb", "push_response")
-	public static function pushResponse(server:CivetWebNative, requestId:Int, statusCode:Int, contentType:hl.Bytes, body:hl.Bytes, bodyLength:Int):Void {}
+	public static function pushResponse(server:CivetWebNative, requestId:Int, statusCode:Int, contentType:hl.Bytes, headers:hl.Bytes, body:hl.Bytes,
+		bodyLength:Int):Void {}
+
+	/**
+	 * Drain up to `max` queued requests into the preallocated `records` in one native call.
+	 * Returns the number of records filled.
+	 */
+	@:hlNative("civetweb", "poll_requests")
+	public static function pollRequests(server:CivetWebNative, records:hl.NativeArray<CivetWebRequestRecord>, max:Int):Int {
+		return 0;
+	}
+
+	/**
+	 * Give each of `count` WorkerIslands its own native request queue, chosen by hashing the `session_id`
+	 * cookie (round-robin without one). pollRequests then finds nothing; islands call pollIsland instead.
+	 * Must be called before start.
+	 */
+	@:hlNative("civetweb", "set_islands")
+	public static function setIslands(server:CivetWebNative, count:Int):Bool {
+		return false;
+	}
+
+	/**
+	 * Block the calling island thread for up to `timeoutMs` until its queue has requests, then drain up
+	 * to `max` of them into `records`. Returns the number of records filled (0 on timeout or stop).
+	 */
+	@:hlNative("civetweb", "poll_island")
+	public static function pollIsland(server:CivetWebNative, island:Int, records:hl.NativeArray<CivetWebRequestRecord>, max:Int, timeoutMs:Int):Int {
+		return 0;
+	}
+
+	/**
+	 * Block the main thread for up to `timeoutMs` until a request reaches the shared queue or a WebSocket
+	 * event is queued. Returns true if work arrived since the last call, false on timeout or stop.
+	 * A timeout of 0 only checks (and rearms the wakeup fd).
+	 */
+	@:hlNative("civetweb", "wait_for_work")
+	public static function waitForWork(server:CivetWebNative, timeoutMs:Int):Bool {
+		return false;
+	}
+
+	/**
+	 * File descriptor (eventfd on Linux, pipe elsewhere) that becomes readable whenever waitForWork would
+	 * return true, for loops that poll descriptors themselves. First call must come before start; -1 on Windows.
+	 */
+	@:hlNative("civetweb", "get_wakeup_fd")
+	public static function getWakeupFd(server:CivetWebNative):Int {
+		return -1;
+	}
+
+	/**
+	 * Complete the first `count` entries of the given arrays in one native call.
+	 */
+	@:hlNative("civetweb", "push_responses")
+	public static function pushResponses(server:CivetWebNative, count:Int, requestIds:hl.NativeArray<Int>, statusCodes:hl.NativeArray<Int>,
+		contentTypes:hl.NativeArray<hl.Bytes>, headers:hl.NativeArray<hl.Bytes>, bodies:hl.NativeArray<hl.Bytes>, bodyLengths:hl.NativeArray<Int>):Void {}
+
+	/**
+	 * Park a request Haxe will hold open (e.g. a long-poll) for up to `timeoutMs` instead of the usual 30 s.
+	 * A parked request keeps its worker thread, but one of the extra long-poll workers rather than one of
+	 * num_threads. Returns false if the request is gone or every extra worker is already taken; answer it
+	 * right away then.
+	 */
+	@:hlNative("civetweb", "suspend_request")
+	public static function suspendRequest(server:CivetWebNative, requestId:Int, timeoutMs:Int):Bool {
+		return false;
+	}
+
+	/**
+	 * Start a streamed (chunked) response instead of calling pushResponse.
+	 * Returns false if the request is no longer waiting or already answered.
+	 */
+	@:hlNative("civetweb", "begin_response")
+	public static function beginResponse(server:CivetWebNative, requestId:Int, statusCode:Int, contentType:hl.Bytes, headers:hl.Bytes):Bool {
+		return false;
+	}
+
+	/**
+	 * Queue one chunk of a streamed response. Blocks while the client is too far behind.
+	 * Returns false once the stream is closed (ended, timed out or client disconnected).
+	 */
+	@:hlNative("civetweb", "push_chunk")
+	public static function pushChunk(server:CivetWebNative, requestId:Int, data:hl.Bytes, length:Int):Bool {
+		return false;
+	}
+
+	/**
+	 * Finish a streamed response; chunks already queued are still written.
+	 */
+	@:hlNative("civetweb", "end_response")
+	public static function endResponse(server:CivetWebNative, requestId:Int):Bool {
+		return false;
+	}
 }
 #else
 abstract CivetWebNative(Dynamic) {
 	public static function create(host:Dynamic, port:Int, documentRoot:Dynamic):CivetWebNative return null;
 	public static function start(server:CivetWebNative):Bool return false;
 	public static function stop(server:CivetWebNative):Void {}
+	public static function setOption(server:CivetWebNative, name:Dynamic, value:Dynamic):Bool return false;
+	public static function setMaxBodySize(server:CivetWebNative, maxBytes:Int):Void {}
+	public static function setKeepAlive(server:CivetWebNative, enabled:Bool, idleTimeoutMs:Int):Void {}
+	public static function setMaxSuspended(server:CivetWebNative, maxSuspended:Int):Void {}
+	public static function getWorkerThreads(server:CivetWebNative):Int return 0;
+	public static function setDefaultTimeout(server:CivetWebNative, timeoutMs:Int):Void {}
+	public static function setRouteTimeout(server:CivetWebNative, method:Dynamic, pattern:Dynamic, timeoutMs:Int):Bool return false;
+	public static function setMaxQueueDepth(server:CivetWebNative, maxDepth:Int):Void {}
+	public static function getQueueStats(server:CivetWebNative, stats:CivetWebQueueStats):Void {}
+	public static function getStats(server:CivetWebNative, stages:Dynamic, reset:Bool):Int return 0;
+	public static function getContextInfo(server:CivetWebNative):Dynamic return null;
+	public static function getConnectionInfo(server:CivetWebNative, index:Int):Dynamic return null;
 	public static function isRunning(server:CivetWebNative):Bool return false;
 	public static function getPort(server:CivetWebNative):Int return 0;
 	public static function getHost(server:CivetWebNative):Dynamic return null;
 	public static function free(server:CivetWebNative):Void {}
 	public static function pollWebSocketEvent(server:CivetWebNative):Dynamic return null;
-	public static function websocketSend(conn:Dynamic, opcode:Int, data:Dynamic, length:Int):Int return -1;
-	public static function websocketClose(conn:Dynamic, code:Int, reason:Dynamic):Void {}
-	public static function pollRequest(server:CivetWebNative):Dynamic return null;
-	public static function pushResponse(server:CivetWebNative, requestId:Int, statusCode:Int, contentType:Dynamic, body:Dynamic, bodyLength:Int):Void {}
+	public static function pollWebSocketEvents(server:CivetWebNative, events:Dynamic, max:Int):Int return 0;
+	public static function setTraceLevel(level:Int):Void {}
+	public static function drainTrace(records:Dynamic, max:Int):Int return 0;
+	public static function getPoolStats(classes:Dynamic):Int return 0;
+	public static function setPoolLimit(bytes:Int):Void {}
+	public static function websocketSend(server:CivetWebNative, connId:Int, opcode:Int, data:Dynamic, length:Int):Int return -1;
+	public static function websocketClose(server:CivetWebNative, connId:Int, code:Int, reason:Dynamic):Void {}
+	public static function websocketAccept(server:CivetWebNative, connId:Int, accept:Bool):Bool return false;
+	public static function addWebSocketPath(server:CivetWebNative, path:Dynamic):Bool return false;
+	public static function addStaticMount(server:CivetWebNative, prefix:Dynamic, directory:Dynamic, cacheControl:Dynamic):Bool return false;
+	public static function setCompression(server:CivetWebNative, minSize:Int, level:Int):Void {}
+	public static function addCompressibleType(server:CivetWebNative, prefix:Dynamic):Bool return false;
+	public static function setWebSocketAcceptTimeout(server:CivetWebNative, timeoutMs:Int):Void {}
+	public static function setMaxPendingHandshakes(server:CivetWebNative, maxPending:Int):Void {}
+	public static function websocketBroadcast(server:CivetWebNative, connIds:Dynamic, count:Int, opcode:Int, data:Dynamic, length:Int):Int return 0;
+	public static function pollRequest(server:CivetWebNative, record:CivetWebRequestRecord):Bool return false;
+	public static function pushResponse(server:CivetWebNative, requestId:Int, statusCode:Int, contentType:Dynamic, headers:Dynamic, body:Dynamic, bodyLength:Int):Void {}
+	public static function pollRequests(server:CivetWebNative, records:Dynamic, max:Int):Int return 0;
+	public static function setIslands(server:CivetWebNative, count:Int):Bool return false;
+	public static function pollIsland(server:CivetWebNative, island:Int, records:Dynamic, max:Int, timeoutMs:Int):Int return 0;
+	public static function waitForWork(server:CivetWebNative, timeoutMs:Int):Bool return false;
+	public static function getWakeupFd(server:CivetWebNative):Int return -1;
+	public static function pushResponses(server:CivetWebNative, count:Int, requestIds:Dynamic, statusCodes:Dynamic, contentTypes:Dynamic, headers:Dynamic, bodies:Dynamic,
+		bodyLengths:Dynamic):Void {}
+	public static function suspendRequest(server:CivetWebNative, requestId:Int, timeoutMs:Int):Bool return false;
+	public static function beginResponse(server:CivetWebNative, requestId:Int, statusCode:Int, contentType:Dynamic, headers:Dynamic):Bool return false;
+	public static function pushChunk(server:CivetWebNative, requestId:Int, data:Dynamic, length:Int):Bool return false;
+	public static function endResponse(server:CivetWebNative, requestId:Int):Bool return false;
 }
 #end
 
@@ -98,20 +432,228 @@ typedef CivetWebResponse = {
 	var contentType:String;
 	var body:String;
 	var bodyLength:Int;
+	var ?headers:Map<String, String>;
+	/** When set, the body is streamed: this is called with an open stream instead of sending `body` */
+	var ?stream:CivetWebResponseStream->Void;
 }
 
 /**
- * Queued request with ID (for polling architecture)
+ * Writer for a streamed (chunked) response, handed to the `stream` callback of a response.
+ * Writes may block while the client is too far behind; they return false once the client
+ * is gone or the stream timed out, so producers should stop then. Call end() when done.
  */
-typedef QueuedRequest = {
-	var id:Int;
-	var uri:String;
-	var method:String;
-	var body:String;
-	var bodyLength:Int;
-	var queryString:String;
-	var remoteAddr:String;
-	var headers:String;
+class CivetWebResponseStream {
+	public var requestId(default, null):Int;
+	public var open(default, null):Bool = true;
+
+	private var server:CivetWebNative;
+
+	public function new(server:CivetWebNative, requestId:Int) {
+		this.server = server;
+		this.requestId = requestId;
+	}
+
+	public function write(s:String):Bool {
+		if (s == null || s.length == 0) return open;
+		return writeBytes(haxe.io.Bytes.ofString(s));
+	}
+
+	public function writeBytes(b:haxe.io.Bytes):Bool {
+		if (!open) return false;
+		#if hl
+		if (!CivetWebNative.pushChunk(server, requestId, @:privateAccess b.b, b.length)) open = false;
+		#end
+		return open;
+	}
+
+	public function end():Void {
+		if (!open) return;
+		open = false;
+		CivetWebNative.endResponse(server, requestId);
+	}
+}
+
+#if hl
+/**
+ * Responses collected on one thread and completed with a single pushResponses call, so a poll
+ * that answers many requests crosses into native code once. Not thread-safe: each island and
+ * the main loop keep their own. The arrays keep the bodies alive until flush().
+ */
+class CivetWebResponseBatch {
+	public var count(default, null):Int = 0;
+
+	private var server:CivetWebNative;
+	private var requestIds:hl.NativeArray<Int>;
+	private var statusCodes:hl.NativeArray<Int>;
+	private var contentTypes:hl.NativeArray<hl.Bytes>;
+	private var headers:hl.NativeArray<hl.Bytes>;
+	private var bodies:hl.NativeArray<hl.Bytes>;
+	private var bodyLengths:hl.NativeArray<Int>;
+
+	public function new(server:CivetWebNative, capacity:Int) {
+		this.server = server;
+		requestIds = new hl.NativeArray<Int>(capacity);
+		statusCodes = new hl.NativeArray<Int>(capacity);
+		contentTypes = new hl.NativeArray<hl.Bytes>(capacity);
+		headers = new hl.NativeArray<hl.Bytes>(capacity);
+		bodies = new hl.NativeArray<hl.Bytes>(capacity);
+		bodyLengths = new hl.NativeArray<Int>(capacity);
+	}
+
+	/** Queue a response (arguments as for pushResponse); a full batch is flushed first */
+	public function add(requestId:Int, statusCode:Int, contentType:hl.Bytes, headerBlock:hl.Bytes, body:hl.Bytes, bodyLength:Int):Void {
+		if (count == requestIds.length) flush();
+		requestIds[count] = requestId;
+		statusCodes[count] = statusCode;
+		contentTypes[count] = contentType;
+		headers[count] = headerBlock;
+		bodies[count] = body;
+		bodyLengths[count] = bodyLength;
+		count++;
+	}
+
+	public function flush():Void {
+		if (count == 0) return;
+		CivetWebNative.pushResponses(server, count, requestIds, statusCodes, contentTypes, headers, bodies, bodyLengths);
+		for (i in 0...count) {
+			contentTypes[i] = null;
+			headers[i] = null;
+			bodies[i] = null;
+		}
+		count = 0;
+	}
+}
+#end
+
+/**
+ * Queued request with ID (for polling architecture).
+ * Filled in place by the native poll functions; the native side mirrors this
+ * field order (hl_request_record in civetweb_hl.c), so keep them in sync.
+ * Byte fields are fresh copies per poll, so a record can be reused once read.
+ */
+@:keep
+class CivetWebRequestRecord {
+	public var id:Int = 0;
+	public var bodyLength:Int = 0;
+	#if hl
+	public var uri:hl.Bytes;
+	public var method:hl.Bytes;
+	public var body:hl.Bytes;
+	public var queryString:hl.Bytes;
+	public var remoteAddr:hl.Bytes;
+	public var headers:hl.Bytes;
+	#end
+
+	public function new() {}
+}
+
+/**
+ * WebSocket event, filled in place by pollWebSocketEvents (field order mirrors
+ * hl_websocket_event in civetweb_hl.c). `data` is a fresh copy per poll.
+ */
+@:keep
+class CivetWebWebSocketEvent {
+	/** 0 = connect, 1 = ready, 2 = data, 3 = close */
+	public var type:Int = 0;
+	public var flags:Int = 0;
+	public var dataLength:Int = 0;
+	/** Connection id from the native handle table */
+	public var connId:Int = 0;
+	#if hl
+	/** Payload for data events; for connect events the handshake block (see parseHandshake) */
+	public var data:hl.Bytes;
+	#end
+
+	public function new() {}
+}
+
+/**
+ * Native trace event, filled in place by drainTrace (field order mirrors
+ * hl_trace_event in civetweb_hl.c).
+ */
+@:keep
+class CivetWebTraceEvent {
+	/** 0 = debug, 1 = info, 2 = warn, 3 = error */
+	public var level:Int = 0;
+	/** Native event code (TRACE_* in civetweb_hl.c) */
+	public var code:Int = 0;
+	/** Request the event concerns, or 0 */
+	public var requestId:Int = 0;
+	/** Time between the event and the drain, in milliseconds */
+	public var ageMs:Int = 0;
+	#if hl
+	public var message:hl.Bytes;
+	#end
+
+	public function new() {}
+}
+
+/**
+ * Request queue metrics, filled in place by getQueueStats (field order mirrors
+ * hl_queue_stats in civetweb_hl.c).
+ */
+@:keep
+class CivetWebQueueStats {
+	/** Requests waiting for Haxe to poll them */
+	public var depth:Int = 0;
+	/** High-water mark (0 = unbounded) */
+	public var maxDepth:Int = 0;
+	/** Requests answered 503 without reaching Haxe (queue full or deadline unreachable), since start */
+	public var rejected:Int = 0;
+	/** Time the oldest queued request has been waiting, in milliseconds */
+	public var oldestAgeMs:Int = 0;
+	/** WebSocket events lost because the event ring stayed full or memory ran out, since start */
+	public var wsEventsDropped:Int = 0;
+
+	public function new() {}
+}
+
+/**
+ * Latency of one request stage, filled in place by getStats (field order mirrors
+ * hl_stage_stats in civetweb_hl.c). Percentiles come from a log-linear histogram
+ * and are within 12.5% of the exact value.
+ */
+@:keep
+class CivetWebStageStats {
+	/**
+	 * Stage names in getStats order: time in the native queue, gap between poll calls (main loop
+	 * cadence), Haxe dispatch and island processing, handoff back to the worker, mg_write of the
+	 * response, and handler entry to last byte for buffered responses.
+	 */
+	public static var STAGES:Array<String> = ["queue_wait", "poll_interval", "processing", "response_wait", "write", "total"];
+
+	/** Samples recorded */
+	public var count:Float = 0;
+	/** Sum of all samples in microseconds (sumUs / count is the mean) */
+	public var sumUs:Float = 0;
+	public var p50Us:Int = 0;
+	public var p90Us:Int = 0;
+	public var p99Us:Int = 0;
+	public var p999Us:Int = 0;
+	public var maxUs:Int = 0;
+
+	public function new() {}
+}
+
+/**
+ * Node pool usage for one size class, filled in place by getPoolStats (field order mirrors
+ * hl_pool_stats in civetweb_hl.c). Blocks held in thread caches count as live, so
+ * live - cached is an upper bound on blocks in use.
+ */
+@:keep
+class CivetWebPoolStats {
+	/** Times the pool had to call malloc (a steady rise means the pool limit is too low) */
+	public var mallocs:Float = 0;
+	/** Block size in bytes, header included; 0 for blocks too large to pool */
+	public var blockSize:Int = 0;
+	/** Blocks taken from malloc and not yet returned to it */
+	public var live:Int = 0;
+	/** Most blocks live at once */
+	public var highWater:Int = 0;
+	/** Free blocks in the shared depot */
+	public var cached:Int = 0;
+
+	public function new() {}
 }
 
 /**
@@ -136,6 +136,7 @@ class AutoRouter {
 							var requiresAuth = false;
 							var requiredPermission:String = null;
 							var defaultStatusCode:Int = 200;
+							var timeoutMs:Int = 0;
 							for (m in field.meta.get()) {
 								switch (m.name) {
 									case "get", "post", "put", "delete", "patch":
@@ -176,6 +177,16 @@ class AutoRouter {
 													Context.error('Expected integer literal in @status', p.pos);
 											}
 										}
+									case "timeout":
+										if (m.params.length > 0) {
+											var p = m.params[0];
+											switch (p.expr) {
+												case EConst(CInt(s)):
+													timeoutMs = Std.parseInt(s);
+												default:
+													Context.error('Expected integer literal (milliseconds) in @timeout', p.pos);
+											}
+										}
 									default:
 								}
 							}
@@ -474,11 +485,11 @@ class AutoRouter {
 
 									for (r in routesToRegister) {
 										var addRoute:Expr = switch r.method {
-											case "get": macro __autoRouter.add("GET", $v{r.path}, $handler);
-											case "post": macro __autoRouter.add("POST", $v{r.path}, $handler);
-											case "put": macro __autoRouter.add("PUT", $v{r.path}, $handler);
-											case "delete": macro __autoRouter.add("DELETE", $v{r.path}, $handler);
-											case "patch": macro __autoRouter.add("PATCH", $v{r.path}, $handler);
+											case "get": macro __autoRouter.add("GET", $v{r.path}, $handler, $v{timeoutMs});
+											case "post": macro __autoRouter.add("POST", $v{r.path}, $handler, $v{timeoutMs});
+											case "put": macro __autoRouter.add("PUT", $v{r.path}, $handler, $v{timeoutMs});
+											case "delete": macro __autoRouter.add("DELETE", $v{r.path}, $handler, $v{timeoutMs});
+											case "patch": macro __autoRouter.add("PATCH", $v{r.path}, $handler, $v{timeoutMs});
 											default: null;
 										};
 
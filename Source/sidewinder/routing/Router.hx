@@ -61,11 +61,13 @@ class Route {
 	public var regex:EReg;
 	public var paramNames:Array<String>;
 	public var handler:Handler;
+	public var timeoutMs:Int; // How long the server waits for this handler; 0 uses the server default
 
-	public function new(method:String, pattern:String, handler:Handler) {
+	public function new(method:String, pattern:String, handler:Handler, timeoutMs:Int = 0) {
 		this.method = method;
 		this.pattern = pattern;
 		this.handler = handler;
+		this.timeoutMs = timeoutMs;
 		var parts = pattern.split("/");
 		var reParts = [];
 		paramNames = [];
@@ -114,8 +116,8 @@ class Router {
 
 	public function new() {}
 
-	public function add(method:String, pattern:String, handler:Handler):Void {
-		routes.push(new Route(method, pattern, handler));
+	public function add(method:String, pattern:String, handler:Handler, timeoutMs:Int = 0):Void {
+		routes.push(new Route(method, pattern, handler, timeoutMs));
 	}
 
 	public function use(mw:Middleware):Void {
@@ -1,5 +1,6 @@
 package sidewinder.routing;
 import sidewinder.interfaces.IWebSocketHandler.WebSocketOpcode;
+import sidewinder.interfaces.IWebSocketHandler.WebSocketConnectionId;
 import sidewinder.interfaces.IWebSocketServer;
 
 import hx.well.websocket.WebSocketSession;
@@ -18,9 +19,10 @@ import haxe.Json;
 
 /**
  * WebSocket router that dispatches connections to different handlers
- * based on the first message sent by the client.
+ * based on the last segment of the upgrade path, or failing that the
+ * first message sent by the client.
  * 
- * Client sends: {"handler": "echo"} or {"handler": "chat"} etc.
+ * Client connects to /ws/chat, or sends: {"handler": "echo"} or {"handler": "chat"} etc.
  * Router assigns connection to appropriate handler.
  * 
  * Supported handlers: "echo", "chat", "broadcast", "auth"
@@ -32,12 +34,13 @@ class WebSocketRouter implements IWebSocketHandler {
 	private var handlers:Map<String, IWebSocketHandler>;
 
 	// Store connections with their state - using class instances for proper reference semantics
-	private var connections:Array<RouterConnection>;
+	private var connections:Map<WebSocketConnectionId, RouterConnection>;
+	private var connectionCount:Int = 0;
 
 	public function new(adapter:IWebSocketServer) {
 		this.adapter = adapter;
 		this.handlers = new Map();
-		this.connections = [];
+		this.connections = new Map();
 
 		// Register default handlers
 		registerHandler("echo", new EchoWebSocketHandler(adapter));
@@ -55,37 +58,41 @@ class WebSocketRouter implements IWebSocketHandler {
 		handlers.set(name, handler);
 	}
 
-	/**
-	 * Find connection entry by comparing connection pointers
-	 */
-	private function findConnection(conn:Dynamic):Null<RouterConnection> {
-		for (entry in connections) {
-			if (conn == entry.conn) {
-				return entry;
+	public function onConnect(conn:WebSocketConnectionId, req:Router.Request):Bool {
+		var entry = new RouterConnection(conn);
+
+		// A path naming a handler (/ws/chat) assigns it up front and lets it accept or refuse the handshake
+		var name = req.path.substr(req.path.lastIndexOf("/") + 1);
+		var handler = handlers.get(name);
+		if (handler != null) {
+			if (!handler.onConnect(conn, req)) {
+				HybridLogger.info('[WebSocketRouter] Connection refused by handler: $name');
+				return false;
 			}
+			entry.handler = handler;
+			entry.pending = false;
 		}
-		return null;
-	}
 
-	/**
-	 * Remove connection entry
-	 */
-	private function removeConnection(conn:Dynamic):Void {
-		connections = connections.filter(entry -> {
-			return conn != entry.conn;
-		});
+		connections.set(conn, entry);
+		connectionCount++;
+		HybridLogger.info('[WebSocketRouter] New connection on ${req.path}');
+		return true;
 	}
 
-	public function onConnect():Bool {
-		HybridLogger.info('[WebSocketRouter] New connection');
-		return true; // Accept all connections
-	}
+	public function onReady(conn:WebSocketConnectionId):Void {
+		var entry = connections.get(conn);
+		if (entry == null) {
+			entry = new RouterConnection(conn);
+			connections.set(conn, entry);
+			connectionCount++;
+		}
 
-	public function onReady(conn:Dynamic):Void {
-		// Add connection as pending
-		connections.push(new RouterConnection(conn));
+		if (!entry.pending) {
+			entry.handler.onReady(conn);
+			return;
+		}
 
-		HybridLogger.info('[WebSocketRouter] Connection ready - awaiting handler selection (total: ${connections.length})');
+		HybridLogger.info('[WebSocketRouter] Connection ready - awaiting handler selection (total: $connectionCount)');
 
 		// Send instructions to client
 		var instructions = Json.stringify({
@@ -97,8 +104,8 @@ class WebSocketRouter implements IWebSocketHandler {
 	}
 
 #if hl
-	public function onData(conn:Dynamic, flags:Int, data:hl.Bytes, length:Int):Void {
-		var entry = findConnection(conn);
+	public function onData(conn:WebSocketConnectionId, flags:Int, data:hl.Bytes, length:Int):Void {
+		var entry = connections.get(conn);
 		if (entry == null) {
 			HybridLogger.warn('[WebSocketRouter] Received data for unknown connection');
 			return;
@@ -163,21 +170,22 @@ class WebSocketRouter implements IWebSocketHandler {
 		}
 	}
 #else
-	public function onData(conn:Dynamic, flags:Int, data:haxe.io.Bytes, length:Int):Void {}
+	public function onData(conn:WebSocketConnectionId, flags:Int, data:haxe.io.Bytes, length:Int):Void {}
 #end
 
-	public function onClose(conn:Dynamic):Void {
-		var entry = findConnection(conn);
+	public function onClose(conn:WebSocketConnectionId):Void {
+		var entry = connections.get(conn);
 
 		if (entry != null) {
 			// Forward close to assigned handler
 			if (entry.handler != null) {
 				entry.handler.onClose(conn);
 			}
-			removeConnection(conn);
+			connections.remove(conn);
+			connectionCount--;
 		}
 
-		HybridLogger.info('[WebSocketRouter] Connection closed (remaining: ${connections.length})');
+		HybridLogger.info('[WebSocketRouter] Connection closed (remaining: $connectionCount)');
 	}
 }
 
@@ -186,11 +194,11 @@ class WebSocketRouter implements IWebSocketHandler {
  * (typedef structs are copied by value, which causes bugs when updating)
  */
 class RouterConnection {
-	public var conn:Dynamic;
+	public var conn:WebSocketConnectionId;
 	public var handler:Null<IWebSocketHandler>;
 	public var pending:Bool;
 
-	public function new(conn:Dynamic) {
+	public function new(conn:WebSocketConnectionId) {
 		this.conn = conn;
 		this.handler = null;
 		this.pending = true;
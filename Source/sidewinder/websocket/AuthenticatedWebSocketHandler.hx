@@ -1,6 +1,7 @@
 package sidewinder.websocket;
 import sidewinder.interfaces.IWebSocketHandler.WebSocketCloseCode;
 import sidewinder.interfaces.IWebSocketHandler.WebSocketOpcode;
+import sidewinder.interfaces.IWebSocketHandler.WebSocketConnectionId;
 import sidewinder.interfaces.IWebSocketServer;
 import sidewinder.interfaces.User;
 
@@ -23,17 +24,19 @@ import sidewinder.core.*;
 
 /**
  * Authenticated WebSocket handler
- * Requires authentication token before allowing communication
+ * Requires authentication token before allowing communication. The token can come with the
+ * upgrade request (?token=, Authorization: Bearer or an auth_token cookie), in which case bad
+ * tokens are refused before the upgrade; otherwise the client sends an auth message first.
  */
 class AuthenticatedWebSocketHandler implements IWebSocketHandler {
 	private var adapter:IWebSocketServer;
-	private var connections:Map<Dynamic, AuthenticatedClient>;
+	private var connections:Map<WebSocketConnectionId, AuthenticatedClient>;
 	private var validTokens:Map<String, TokenInfo>;
 	private var authTimeout:Float; // seconds
 
 	public function new(adapter:IWebSocketServer, authTimeout:Float = 10.0) {
 		this.adapter = adapter;
-		this.connections = new Map<Dynamic, AuthenticatedClient>();
+		this.connections = new Map<WebSocketConnectionId, AuthenticatedClient>();
 		this.validTokens = new Map();
 		this.authTimeout = authTimeout;
 
@@ -58,12 +61,56 @@ class AuthenticatedWebSocketHandler implements IWebSocketHandler {
 		});
 	}
 
-	public function onConnect():Bool {
-		HybridLogger.info('[Auth] New connection request');
-		return true; // Accept connection, but require auth
+	public function onConnect(conn:WebSocketConnectionId, req:Router.Request):Bool {
+		var token = handshakeToken(req);
+		if (token == null) {
+			HybridLogger.info('[Auth] New connection request');
+			return true; // Accept connection, but require auth
+		}
+
+		var tokenInfo = validTokens.get(token);
+		if (tokenInfo == null || Date.now().getTime() > tokenInfo.expiresAt) {
+			HybridLogger.warn('[Auth] Handshake refused: ${tokenInfo == null ? "Invalid token" : "Token expired"}');
+			return false;
+		}
+
+		// Authenticated at handshake time; onReady completes it once frames can be sent
+		connections.set(conn, {
+			conn: conn,
+			authenticated: false,
+			authToken: token,
+			userId: null,
+			username: null,
+			connectedAt: Date.now().getTime(),
+			authDeadline: Date.now().getTime() + (authTimeout * 1000)
+		});
+		return true;
+	}
+
+	/**
+	 * Token sent with the upgrade request, if any
+	 */
+	private function handshakeToken(req:Router.Request):Null<String> {
+		var token = req.query.get("token");
+		if (token != null) return token;
+		var authorization = req.headers.get("Authorization");
+		if (authorization == null) authorization = req.headers.get("authorization");
+		if (authorization != null && StringTools.startsWith(authorization, "Bearer ")) {
+			return StringTools.trim(authorization.substr(7));
+		}
+		return req.cookies.get("auth_token");
 	}
 
-	public function onReady(conn:Dynamic):Void {
+	public function onReady(conn:WebSocketConnectionId):Void {
+		var client = connections.get(conn);
+		if (client != null && client.authToken != null) {
+			var tokenInfo = validTokens.get(client.authToken);
+			if (tokenInfo != null) {
+				completeAuthentication(conn, client, client.authToken, tokenInfo);
+				return;
+			}
+		}
+
 		connections.set(conn, {
 			conn: conn,
 			authenticated: false,
@@ -85,7 +132,7 @@ class AuthenticatedWebSocketHandler implements IWebSocketHandler {
 	}
 
 #if hl
-	public function onData(conn:Dynamic, flags:Int, data:hl.Bytes, length:Int):Void {
+	public function onData(conn:WebSocketConnectionId, flags:Int, data:hl.Bytes, length:Int):Void {
 		var opcode = flags & 0x0F;
 
 		if (opcode == WebSocketOpcode.TEXT) {
@@ -171,10 +218,10 @@ class AuthenticatedWebSocketHandler implements IWebSocketHandler {
 		}
 	}
 #else
-	public function onData(conn:Dynamic, flags:Int, data:haxe.io.Bytes, length:Int):Void {}
+	public function onData(conn:WebSocketConnectionId, flags:Int, data:haxe.io.Bytes, length:Int):Void {}
 #end
 
-	public function onClose(conn:Dynamic):Void {
+	public function onClose(conn:WebSocketConnectionId):Void {
 		var client = connections.get(conn);
 
 		if (client != null) {
@@ -196,7 +243,7 @@ class AuthenticatedWebSocketHandler implements IWebSocketHandler {
 		}
 	}
 
-	private function handleAuthentication(conn:Dynamic, client:AuthenticatedClient, token:String):Void {
+	private function handleAuthentication(conn:WebSocketConnectionId, client:AuthenticatedClient, token:String):Void {
 		// Check auth deadline
 		if (Date.now().getTime() > client.authDeadline) {
 			var timeoutMsg = {
@@ -232,6 +279,10 @@ class AuthenticatedWebSocketHandler implements IWebSocketHandler {
 			return;
 		}
 
+		completeAuthentication(conn, client, token, tokenInfo);
+	}
+
+	private function completeAuthentication(conn:WebSocketConnectionId, client:AuthenticatedClient, token:String, tokenInfo:TokenInfo):Void {
 		// Authentication successful
 		client.authenticated = true;
 		client.authToken = token;
@@ -258,19 +309,11 @@ class AuthenticatedWebSocketHandler implements IWebSocketHandler {
 	}
 
 	private function broadcastToAuthenticated(message:String):Void {
-		for (client in connections) {
-			if (client.authenticated) {
-				adapter.websocketSendText(client.conn, message);
-			}
-		}
+		adapter.websocketBroadcastText([for (client in connections) if (client.authenticated) client.conn], message);
 	}
 
-	private function broadcastToAuthenticatedExcept(excludeConn:Dynamic, message:String):Void {
-		for (client in connections) {
-			if (client.authenticated && client.conn != excludeConn) {
-				adapter.websocketSendText(client.conn, message);
-			}
-		}
+	private function broadcastToAuthenticatedExcept(excludeConn:WebSocketConnectionId, message:String):Void {
+		adapter.websocketBroadcastText([for (client in connections) if (client.authenticated && client.conn != excludeConn) client.conn], message);
 	}
 
 	private function sendToUser(username:String, message:String):Void {
@@ -321,7 +364,7 @@ class AuthenticatedWebSocketHandler implements IWebSocketHandler {
 }
 
 typedef AuthenticatedClient = {
-	var conn:Dynamic;
+	var conn:WebSocketConnectionId;
 	var authenticated:Bool;
 	var authToken:String;
 	var userId:Null<Int>;
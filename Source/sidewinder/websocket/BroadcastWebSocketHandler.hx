@@ -1,5 +1,6 @@
 package sidewinder.websocket;
 import sidewinder.interfaces.IWebSocketHandler.WebSocketOpcode;
+import sidewinder.interfaces.IWebSocketHandler.WebSocketConnectionId;
 import sidewinder.interfaces.IWebSocketServer;
 
 import sidewinder.adapters.*;
@@ -25,48 +26,51 @@ import sidewinder.core.*;
  */
 class BroadcastWebSocketHandler implements IWebSocketHandler {
 	private var adapter:IWebSocketServer;
-	private var connections:Array<BroadcastConnection>;
+	private var connections:Map<WebSocketConnectionId, BroadcastConnection>;
+	private var connectionCount:Int;
 	private var nextClientId:Int;
 	private var totalMessages:Int;
 	private var startTime:Float;
 
 	public function new(adapter:IWebSocketServer) {
 		this.adapter = adapter;
-		this.connections = [];
+		this.connections = new Map();
+		this.connectionCount = 0;
 		this.nextClientId = 1;
 		this.totalMessages = 0;
 		this.startTime = Date.now().getTime();
 	}
 
-	public function onConnect():Bool {
+	public function onConnect(conn:WebSocketConnectionId, req:Router.Request):Bool {
 		HybridLogger.info('[Broadcast] New connection request');
 		return true;
 	}
 
-	public function onReady(conn:Dynamic):Void {
+	public function onReady(conn:WebSocketConnectionId):Void {
 		var clientId = "client-" + nextClientId++;
 		var client = new BroadcastConnection(conn, clientId);
-		connections.push(client);
+		connections.set(conn, client);
+		connectionCount++;
 
-		HybridLogger.info('[Broadcast] Client connected: $clientId (${connections.length} total)');
+		HybridLogger.info('[Broadcast] Client connected: $clientId ($connectionCount total)');
 
 		// Send welcome message with expected format for broadcast_demo.html
 		var welcomeMsg = {
 			type: "welcome",
 			message: "Connected to broadcast server",
 			clientId: clientId,
-			totalClients: connections.length
+			totalClients: connectionCount
 		};
 		adapter.websocketSendText(conn, haxe.Json.stringify(welcomeMsg));
 	}
 
 #if hl
-	public function onData(conn:Dynamic, flags:Int, data:hl.Bytes, length:Int):Void {
+	public function onData(conn:WebSocketConnectionId, flags:Int, data:hl.Bytes, length:Int):Void {
 		var opcode = flags & 0x0F;
 
 		if (opcode == WebSocketOpcode.TEXT) {
 			var message = @:privateAccess String.fromUTF8(data);
-			var client = findConnection(conn);
+			var client = connections.get(conn);
 
 			if (client == null) {
 				HybridLogger.warn('[Broadcast] Message from unknown connection');
@@ -100,7 +104,7 @@ class BroadcastWebSocketHandler implements IWebSocketHandler {
 						// Return stats for this client
 						var statsMsg = {
 							type: "stats",
-							totalClients: connections.length,
+							totalClients: connectionCount,
 							totalMessages: totalMessages,
 							yourMessages: client.messageCount,
 							uptime: Date.now().getTime() - startTime
@@ -134,43 +138,33 @@ class BroadcastWebSocketHandler implements IWebSocketHandler {
 		}
 	}
 #else
-	public function onData(conn:Dynamic, flags:Int, data:haxe.io.Bytes, length:Int):Void {}
+	public function onData(conn:WebSocketConnectionId, flags:Int, data:haxe.io.Bytes, length:Int):Void {}
 #end
 
-	public function onClose(conn:Dynamic):Void {
-		var client = findConnection(conn);
+	public function onClose(conn:WebSocketConnectionId):Void {
+		var client = connections.get(conn);
 
 		if (client != null) {
-			connections.remove(client);
-			HybridLogger.info('[Broadcast] Client disconnected: ${client.clientId} (${connections.length} remaining)');
+			connections.remove(conn);
+			connectionCount--;
+			HybridLogger.info('[Broadcast] Client disconnected: ${client.clientId} ($connectionCount remaining)');
 
 			// Notify remaining clients
 			var leaveMsg = {
 				type: "system",
 				message: '${client.clientId} disconnected',
-				totalClients: connections.length
+				totalClients: connectionCount
 			};
 			broadcastToAll(haxe.Json.stringify(leaveMsg));
 		}
 	}
 
-	private function findConnection(conn:Dynamic):Null<BroadcastConnection> {
-		for (client in connections) {
-			if (conn == client.conn) {
-				return client;
-			}
-		}
-		return null;
-	}
-
 	private function broadcastToAll(message:String):Void {
-		for (client in connections) {
-			adapter.websocketSendText(client.conn, message);
-		}
+		adapter.websocketBroadcastText([for (conn in connections.keys()) conn], message);
 	}
 
 	public function getConnectionCount():Int {
-		return connections.length;
+		return connectionCount;
 	}
 }
 
@@ -178,12 +172,12 @@ class BroadcastWebSocketHandler implements IWebSocketHandler {
  * Connection state - using a class for proper reference semantics
  */
 class BroadcastConnection {
-	public var conn:Dynamic;
+	public var conn:WebSocketConnectionId;
 	public var clientId:String;
 	public var messageCount:Int;
 	public var connectedAt:Float;
 
-	public function new(conn:Dynamic, clientId:String) {
+	public function new(conn:WebSocketConnectionId, clientId:String) {
 		this.conn = conn;
 		this.clientId = clientId;
 		this.messageCount = 0;
@@ -1,5 +1,6 @@
 package sidewinder.websocket;
 import sidewinder.interfaces.IWebSocketHandler.WebSocketOpcode;
+import sidewinder.interfaces.IWebSocketHandler.WebSocketConnectionId;
 import sidewinder.interfaces.IWebSocketServer;
 import sidewinder.interfaces.User;
 
@@ -26,38 +27,41 @@ import sidewinder.core.*;
  */
 class ChatRoomWebSocketHandler implements IWebSocketHandler {
 	private var adapter:IWebSocketServer;
-	private var connections:Array<ConnectionInfo>;
+	private var connections:Map<WebSocketConnectionId, ConnectionInfo>;
+	private var connectionCount:Int;
 	private var nextUserId:Int;
 
 	public function new(adapter:IWebSocketServer) {
 		this.adapter = adapter;
-		this.connections = [];
+		this.connections = new Map();
+		this.connectionCount = 0;
 		this.nextUserId = 1;
 	}
 
-	public function onConnect():Bool {
+	public function onConnect(conn:WebSocketConnectionId, req:Router.Request):Bool {
 		HybridLogger.info('[ChatRoom] New connection request');
 		return true;
 	}
 
-	public function onReady(conn:Dynamic):Void {
+	public function onReady(conn:WebSocketConnectionId):Void {
 		var userId = nextUserId++;
 		var username = "User" + userId;
 
-		connections.push({
+		connections.set(conn, {
 			conn: conn,
 			userId: userId,
 			username: username,
 			connectedAt: Date.now().getTime()
 		});
+		connectionCount++;
 
-		HybridLogger.info('[ChatRoom] User connected: $username (${connections.length} users online)');
+		HybridLogger.info('[ChatRoom] User connected: $username ($connectionCount users online)');
 
 		// Send welcome message to new user
 		var welcomeMsg = {
 			type: "system",
 			message: 'Welcome to the chat room! You are $username',
-			userCount: connections.length
+			userCount: connectionCount
 		};
 		adapter.websocketSendText(conn, haxe.Json.stringify(welcomeMsg));
 
@@ -66,12 +70,12 @@ class ChatRoomWebSocketHandler implements IWebSocketHandler {
 			type: "join",
 			username: username,
 			message: '$username joined the chat',
-			userCount: connections.length
+			userCount: connectionCount
 		};
 		broadcastToOthers(conn, haxe.Json.stringify(joinMsg));
 
 		// Send user list to new user
-		var userList = connections.map(c -> c.username);
+		var userList = getUserList();
 		var userListMsg = {
 			type: "userlist",
 			users: userList
@@ -80,12 +84,12 @@ class ChatRoomWebSocketHandler implements IWebSocketHandler {
 	}
 
 #if hl
-	public function onData(conn:Dynamic, flags:Int, data:hl.Bytes, length:Int):Void {
+	public function onData(conn:WebSocketConnectionId, flags:Int, data:hl.Bytes, length:Int):Void {
 		var opcode = flags & 0x0F;
 
 		if (opcode == WebSocketOpcode.TEXT) {
 			var message = @:privateAccess String.fromUTF8(data);
-			var connInfo = findConnection(conn);
+			var connInfo = connections.get(conn);
 
 			if (connInfo == null) {
 				HybridLogger.warn('[ChatRoom] Message from unknown connection');
@@ -131,10 +135,10 @@ class ChatRoomWebSocketHandler implements IWebSocketHandler {
 		}
 	}
 #else
-	public function onData(conn:Dynamic, flags:Int, data:haxe.io.Bytes, length:Int):Void {}
+	public function onData(conn:WebSocketConnectionId, flags:Int, data:haxe.io.Bytes, length:Int):Void {}
 #end
 
-	private function handleCommand(conn:Dynamic, connInfo:ConnectionInfo, message:String):Void {
+	private function handleCommand(conn:WebSocketConnectionId, connInfo:ConnectionInfo, message:String):Void {
 		var parts = message.split(" ");
 		var command = parts[0].toLowerCase();
 		var arg = parts.length > 1 ? parts.slice(1).join(" ") : "";
@@ -197,7 +201,7 @@ class ChatRoomWebSocketHandler implements IWebSocketHandler {
 		}
 	}
 
-	private function changeNickname(conn:Dynamic, connInfo:ConnectionInfo, newName:String):Void {
+	private function changeNickname(conn:WebSocketConnectionId, connInfo:ConnectionInfo, newName:String):Void {
 		if (newName.length > 0 && newName.length <= 20) {
 			var oldName = connInfo.username;
 			connInfo.username = newName;
@@ -237,7 +241,7 @@ class ChatRoomWebSocketHandler implements IWebSocketHandler {
 		}
 	}
 
-	private function sendSystemMessage(conn:Dynamic, message:String):Void {
+	private function sendSystemMessage(conn:WebSocketConnectionId, message:String):Void {
 		adapter.websocketSendText(conn, haxe.Json.stringify({
 			type: "system",
 			message: message
@@ -245,7 +249,7 @@ class ChatRoomWebSocketHandler implements IWebSocketHandler {
 	}
 
 	private function getConnectionsInRoom(room:String):Array<ConnectionInfo> {
-		return connections.filter(c -> c.room == room);
+		return [for (c in connections) if (c.room == room) c];
 	}
 
 	private function getRoomList():Array<String> {
@@ -259,65 +263,48 @@ class ChatRoomWebSocketHandler implements IWebSocketHandler {
 	}
 
 	private function broadcastToRoom(room:String, message:String):Void {
-		for (connInfo in connections) {
-			if (connInfo.room == room) {
-				adapter.websocketSendText(connInfo.conn, message);
-			}
-		}
+		adapter.websocketBroadcastText([for (c in connections) if (c.room == room) c.conn], message);
 	}
 
-	public function onClose(conn:Dynamic):Void {
-		var connInfo = findConnection(conn);
+	public function onClose(conn:WebSocketConnectionId):Void {
+		var connInfo = connections.get(conn);
 
 		if (connInfo != null) {
-			connections.remove(connInfo);
+			connections.remove(conn);
+			connectionCount--;
 
-			HybridLogger.info('[ChatRoom] User disconnected: ${connInfo.username} (${connections.length} users remaining)');
+			HybridLogger.info('[ChatRoom] User disconnected: ${connInfo.username} ($connectionCount users remaining)');
 
 			// Broadcast leave notification
 			var leaveMsg = {
 				type: "leave",
 				username: connInfo.username,
 				message: '${connInfo.username} left the chat',
-				userCount: connections.length
+				userCount: connectionCount
 			};
 			broadcastToAll(haxe.Json.stringify(leaveMsg));
 		}
 	}
 
-	private function findConnection(conn:Dynamic):ConnectionInfo {
-		for (c in connections) {
-			if (c.conn == conn)
-				return c;
-		}
-		return null;
-	}
-
 	private function broadcastToAll(message:String):Void {
-		for (connInfo in connections) {
-			adapter.websocketSendText(connInfo.conn, message);
-		}
+		adapter.websocketBroadcastText([for (conn in connections.keys()) conn], message);
 	}
 
-	private function broadcastToOthers(excludeConn:Dynamic, message:String):Void {
-		for (connInfo in connections) {
-			if (connInfo.conn != excludeConn) {
-				adapter.websocketSendText(connInfo.conn, message);
-			}
-		}
+	private function broadcastToOthers(excludeConn:WebSocketConnectionId, message:String):Void {
+		adapter.websocketBroadcastText([for (conn in connections.keys()) if (conn != excludeConn) conn], message);
 	}
 
 	public function getConnectionCount():Int {
-		return connections.length;
+		return connectionCount;
 	}
 
 	public function getUserList():Array<String> {
-		return connections.map(c -> c.username);
+		return [for (c in connections) c.username];
 	}
 }
 
 typedef ConnectionInfo = {
-	var conn:Dynamic;
+	var conn:WebSocketConnectionId;
 	var userId:Int;
 	var username:String;
 	var connectedAt:Float;
@@ -1,6 +1,7 @@
 package sidewinder.websocket;
 import sidewinder.interfaces.IWebSocketHandler.WebSocketCloseCode;
 import sidewinder.interfaces.IWebSocketHandler.WebSocketOpcode;
+import sidewinder.interfaces.IWebSocketHandler.WebSocketConnectionId;
 import sidewinder.interfaces.IWebSocketServer;
 
 import sidewinder.adapters.*;
@@ -31,18 +32,18 @@ class EchoWebSocketHandler implements IWebSocketHandler {
         this.adapter = adapter;
     }
     
-    public function onConnect():Bool {
+    public function onConnect(conn:WebSocketConnectionId, req:Router.Request):Bool {
         HybridLogger.info('[EchoWebSocket] New connection request');
         return true; // Accept all connections
     }
     
-    public function onReady(conn:Dynamic):Void {
+    public function onReady(conn:WebSocketConnectionId):Void {
         HybridLogger.info('[EchoWebSocket] Connection ready');
         adapter.websocketSendText(conn, "Welcome to SideWinder WebSocket Echo Server!");
     }
     
 #if hl
-    public function onData(conn:Dynamic, flags:Int, data:hl.Bytes, length:Int):Void {
+    public function onData(conn:WebSocketConnectionId, flags:Int, data:hl.Bytes, length:Int):Void {
         // Extract opcode from flags (lower 4 bits)
         var opcode = flags & 0x0F;
         
@@ -73,10 +74,10 @@ class EchoWebSocketHandler implements IWebSocketHandler {
         }
     }
 #else
-    public function onData(conn:Dynamic, flags:Int, data:haxe.io.Bytes, length:Int):Void {}
+    public function onData(conn:WebSocketConnectionId, flags:Int, data:haxe.io.Bytes, length:Int):Void {}
 #end
     
-    public function onClose(conn:Dynamic):Void {
+    public function onClose(conn:WebSocketConnectionId):Void {
         HybridLogger.info('[EchoWebSocket] Connection closed');
     }
 }
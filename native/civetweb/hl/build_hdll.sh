@@ -76,6 +76,8 @@ echo "[1/3] Compiling civetweb.c..."
 gcc -c -O2 -fPIC -std=c99 \
     -DNO_SSL \
     -DUSE_WEBSOCKET \
+    -DUSE_SERVER_STATS \
+    -DMG_EXPERIMENTAL_INTERFACES \
     ../civetweb.c \
     -o civetweb.o
 
@@ -89,12 +91,18 @@ echo ""
 # ==============================
 # 4. Compile civetweb_hl.c (HashLink bindings)
 # ==============================
+# USE_ZLIB is for the bridge only (response gzip). civetweb.c stays without it: with
+# MG_EXPERIMENTAL_INTERFACES it deflates large WebSocket frames without negotiating
+# permessage-deflate.
 echo "[2/3] Compiling civetweb_hl.c..."
 gcc -c -O2 -fPIC -std=c99 \
     -I"$HASHLINK_PATH/include" \
     -I.. \
     -DNO_SSL \
     -DUSE_WEBSOCKET \
+    -DUSE_SERVER_STATS \
+    -DMG_EXPERIMENTAL_INTERFACES \
+    -DUSE_ZLIB \
     civetweb_hl.c \
     -o civetweb_hl.o
 
@@ -114,6 +122,7 @@ echo "Using library path: $HL_LIB_PATH"
 gcc -shared -o civetweb.hdll \
     civetweb_hl.o civetweb.o \
     -L"$HL_LIB_PATH" -lhl \
+    -lz \
     -lpthread
 
 if [ $? -ne 0 ]; then
@@ -14,16 +14,21 @@ echo "[1/3] Compiling civetweb.c..."
 gcc -c -O2 -arch x86_64 -std=c99 \
     -DNO_SSL \
     -DUSE_WEBSOCKET \
+    -DUSE_SERVER_STATS \
+    -DMG_EXPERIMENTAL_INTERFACES \
     ../civetweb.c \
     -o civetweb.o
 
-# 2. Compile civetweb_hl.c
+# 2. Compile civetweb_hl.c (USE_ZLIB for the bridge only, see build_hdll.sh)
 echo "[2/3] Compiling civetweb_hl.c..."
 gcc -c -O2 -arch x86_64 -std=c99 \
     -I"$HL_INCLUDE" \
     -I.. \
     -DNO_SSL \
     -DUSE_WEBSOCKET \
+    -DUSE_SERVER_STATS \
+    -DMG_EXPERIMENTAL_INTERFACES \
+    -DUSE_ZLIB \
     civetweb_hl.c \
     -o civetweb_hl.o
 
@@ -32,6 +37,7 @@ echo "[3/3] Linking civetweb.hdll..."
 gcc -dynamiclib -arch x86_64 -o civetweb.hdll \
     civetweb_hl.o civetweb.o \
     -L"$HL_LIB" -lhl \
+    -lz \
     -lpthread
 
 if [ $? -eq 0 ]; then
@@ -3,6 +3,14 @@
  * Native C bindings for CivetWeb to be used with HashLink
  */
 
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+// Needed under -std=c99 for strdup, clock_gettime and pthread_cond_timedwait
+#define _POSIX_C_SOURCE 200809L
+#endif
+#ifdef __APPLE__
+#define _DARWIN_C_SOURCE
+#endif
+
 #ifdef _WIN32
 #pragma comment(lib, "ws2_32.lib")
 #pragma comment(lib, "advapi32.lib")
@@ -15,22 +23,63 @@
 #include "civetweb.h"
 #include <string.h>
 #include <stdio.h>
+#include <time.h>
+#include <sys/stat.h>
+#if defined(USE_ZLIB)
+#include <zlib.h>
+#endif
 
 #ifndef _WIN32
 #include <unistd.h>
+#include <fcntl.h>
 #include <strings.h>
+#if defined(__linux__)
+#include <sys/eventfd.h>
+#endif
 #define _stricmp strcasecmp
+#else
+#define strncasecmp _strnicmp
+#define S_ISDIR(m) (((m) & _S_IFMT) == _S_IFDIR)
+#define S_ISREG(m) (((m) & _S_IFMT) == _S_IFREG)
 #endif
 
-// Type definitions for HashLink
+// Static mount: requests under prefix are served from directory without reaching Haxe
 typedef struct {
-    struct mg_context *ctx;
-    struct mg_callbacks callbacks;
-    char *document_root;
-    int port;
-    char *host;
-    int running;
-} hl_civetweb_server;
+    char *prefix;                 // "/assets" (no trailing slash; "/" mounts the whole site)
+    size_t prefix_len;
+    char *directory;              // Filesystem directory the prefix maps to
+    char *cache_control;          // Cache-Control value for files under the mount, NULL for none
+} static_mount;
+
+// Per-route handler timeout, matched with the same patterns as the Haxe Router
+typedef struct {
+    char *method;
+    char *pattern;                // "/users/:id", "/files/:*path"
+    int timeout_ms;
+} route_timeout;
+
+// Server handle (defined below, after the per-server queue types it embeds)
+typedef struct hl_civetweb_server hl_civetweb_server;
+
+// Applied at start unless overridden with set_option
+#define DEFAULT_NUM_THREADS "4"
+#define DEFAULT_MAX_SUSPENDED 64
+#define DEFAULT_TIMEOUT_MS 30000
+#define DEFAULT_MAX_QUEUE_DEPTH 256
+#define DEFAULT_KEEP_ALIVE_TIMEOUT_MS "2000"
+#define DEFAULT_WEBSOCKET_PATH "/ws"
+#define DEFAULT_WEBSOCKET_ACCEPT_TIMEOUT_MS 5000
+#define DEFAULT_MAX_PENDING_HANDSHAKES 8
+#define DEFAULT_COMPRESS_MIN_SIZE 1024
+#define DEFAULT_COMPRESS_LEVEL 6
+#define STOP_DRAIN_MS 5000  // How long stop() lets in-flight requests finish before mg_stop cuts them off
+
+#if defined(USE_ZLIB)
+static const char *DEFAULT_COMPRESS_TYPES[] = {
+    "text/", "application/json", "application/javascript", "application/xml", "image/svg+xml"
+};
+#define NUM_DEFAULT_COMPRESS_TYPES (int)(sizeof(DEFAULT_COMPRESS_TYPES) / sizeof(DEFAULT_COMPRESS_TYPES[0]))
+#endif
 
 typedef struct {
     vbyte *uri;
@@ -49,204 +98,1276 @@ typedef struct {
     int body_length;
 } hl_http_response;
 
+// Mirrors the field layout of the Haxe class sidewinder.native.CivetWebRequestRecord
+// (object header followed by fields in declaration order). Haxe allocates the records,
+// native code fills them in place so no dynamic field hashing happens per request.
+typedef struct {
+    hl_type *t;
+    int id;
+    int body_length;
+    vbyte *uri;
+    vbyte *method;
+    vbyte *body;
+    vbyte *query_string;
+    vbyte *remote_addr;
+    vbyte *headers;
+} hl_request_record;
+
+#define _REQUEST_RECORD _OBJ(_I32 _I32 _BYTES _BYTES _BYTES _BYTES _BYTES _BYTES)
+
+// Mirrors the Haxe class sidewinder.native.CivetWebQueueStats (see hl_request_record)
+typedef struct {
+    hl_type *t;
+    int depth;
+    int max_depth;
+    int rejected;
+    int oldest_age_ms;
+    int ws_events_dropped;
+} hl_queue_stats;
+
+#define _QUEUE_STATS _OBJ(_I32 _I32 _I32 _I32 _I32)
+
 // WebSocket event types
 #define WS_EVENT_CONNECT 0
 #define WS_EVENT_READY 1
 #define WS_EVENT_DATA 2
 #define WS_EVENT_CLOSE 3
 
-// WebSocket event queue entry
-typedef struct queued_websocket_event {
+// Mirrors the Haxe class sidewinder.native.CivetWebWebSocketEvent (see hl_request_record)
+typedef struct {
+    hl_type *t;
     int type;
-    struct mg_connection *conn;
     int flags;
-    char *data;
-    int data_len;
-    struct queued_websocket_event *next;
-} queued_websocket_event;
+    int data_length;
+    int conn_id;
+    vbyte *data;
+} hl_websocket_event;
 
-// Thread-safe queues
-static queued_websocket_event *g_websocket_queue_head = NULL;
-static queued_websocket_event *g_websocket_queue_tail = NULL;
+#define _WEBSOCKET_EVENT _OBJ(_I32 _I32 _I32 _I32 _BYTES)
 
-// Request/Response queues (existing)
-typedef struct queued_request {
+// Mirrors the Haxe class sidewinder.native.CivetWebTraceEvent (see hl_request_record)
+typedef struct {
+    hl_type *t;
+    int level;
+    int code;
     int request_id;
-    struct mg_connection *conn;
-    char uri[512];
-    char method[16];
-    char body[8192];
-    int body_length;
-    char query_string[512];
-    char remote_addr[64];
-    char headers[4096];
-    struct queued_request *next;
-} queued_request;
+    int age_ms;
+    vbyte *message;
+} hl_trace_event;
+
+#define _TRACE_EVENT _OBJ(_I32 _I32 _I32 _I32 _BYTES)
+
+// Mirrors the Haxe class sidewinder.native.CivetWebStageStats (see hl_request_record)
+typedef struct {
+    hl_type *t;
+    double count;
+    double sum_us;
+    int p50_us;
+    int p90_us;
+    int p99_us;
+    int p999_us;
+    int max_us;
+} hl_stage_stats;
+
+#define _STAGE_STATS _OBJ(_F64 _F64 _I32 _I32 _I32 _I32 _I32)
+
+// Node pool usage for one size class, filled in place by get_pool_stats.
+// Mirrors the Haxe class sidewinder.native.CivetWebPoolStats (see hl_request_record)
+typedef struct {
+    hl_type *t;
+    double mallocs;
+    int block_size;     // 0 for blocks too large to pool
+    int live;
+    int high_water;
+    int cached;
+} hl_pool_stats;
 
+#define _POOL_STATS _OBJ(_F64 _I32 _I32 _I32 _I32)
+
+// Mutexes and condition variables for thread safety
+#ifdef _WIN32
+#include <windows.h>
+#include <intrin.h>
+typedef CRITICAL_SECTION hl_mutex;
+typedef CONDITION_VARIABLE hl_cond;
+typedef volatile LONG64 atomic_counter;
+#define THREAD_LOCAL __declspec(thread)
+#else
+#include <pthread.h>
+#include <time.h>
+#include <sched.h>
+typedef pthread_mutex_t hl_mutex;
+typedef pthread_cond_t hl_cond;
+typedef long long atomic_counter;
+#define THREAD_LOCAL __thread
+#endif
+
+// Responses are a single allocation: the struct followed by the content type, header block and body
 typedef struct queued_response {
     int request_id;
     int status_code;
-    char content_type[128];
-    char body[8192];
+    char *content_type;
+    char *headers;              // "Name: value\n" lines, may be empty
+    char *body;
     int body_length;
-    struct queued_response *next;
 } queued_response;
 
-static queued_request *g_request_queue_head = NULL;
-static queued_request *g_request_queue_tail = NULL;
-static queued_response *g_response_queue_head = NULL;
-static queued_response *g_response_queue_tail = NULL;
-static int g_next_request_id = 1;
+// One piece of a streamed response body; the data follows the struct
+typedef struct response_chunk {
+    struct response_chunk *next;
+    int length;
+} response_chunk;
+
+// Request/Response queues
+// Each request doubles as the completion slot its CivetWeb worker waits on:
+// push_response stores the response in it and signals 'done' directly.
+typedef struct queued_request {
+    int request_id;
+    struct mg_connection *conn;
+    char *uri;                          // Strings live in the same allocation as the struct
+    char *method;
+    char *query_string;
+    char *remote_addr;
+    char *headers;
+    char *body;                         // Separately allocated, sized to the request body
+    int body_length;
+    int timeout_ms;                     // Route timeout; also the idle limit of a streamed response
+    long long enqueued_ms;              // now_ms() time the request entered the pending queue
+    long long accepted_us;              // now_us() stage timestamps for the latency histograms
+    long long enqueued_us;
+    atomic_counter polled_us;           // Set under the queue mutex, read under the response mutex
+    long long responded_us;
+    long long deadline_ms;              // now_ms() time the worker gives up (guarded by the server's response_mutex)
+    int suspended;                      // Parked by suspend_request (guarded by the server's response_mutex)
+    queued_response *response;          // Set by push_response (guarded by the server's response_mutex)
+    hl_cond done;                       // Signaled when response is set, a chunk arrives or the stream ends
+    int streaming;                      // begin_response was used: the body follows as chunks
+    int stream_ended;                   // end_response was called
+    int stream_closed;                  // The worker is done with the stream; producers must stop
+    int stream_waiters;                 // push_chunk calls blocked on 'drained'
+    response_chunk *chunks_head;        // Chunks not yet written to the connection
+    response_chunk *chunks_tail;
+    size_t chunk_bytes;                 // Bytes queued in chunks_head
+    hl_cond drained;                    // Signaled when the worker has written queued chunks
+    struct request_queue *queue;        // Queue the request was put on (see select_queue)
+    struct queued_request *next;        // Link in that queue
+} queued_request;
+
+// Requests waiting to be polled: the shared queue behind poll_requests, or one island's queue.
+// Each queue has its own lock, so islands never contend with each other.
+typedef struct request_queue {
+    hl_mutex mutex;
+    queued_request *head;               // Guarded by mutex, as is the rest
+    queued_request *tail;
+    int depth;
+    long long last_poll_us;             // now_us() time of the last poll of this queue
+    hl_cond ready;                      // Signaled when a request is enqueued (poll_island waits on it)
+} request_queue;
+
+// Default cap on request bodies (see set_max_body_size)
+#define DEFAULT_MAX_BODY_SIZE (64 * 1024 * 1024)
+
+// push_chunk blocks while this many bytes of a stream are still waiting to be written
+#define STREAM_BACKLOG_LIMIT (1024 * 1024)
+
+// In-flight requests are indexed by request ID for O(1) response delivery.
+// A request ID packs the slot index (low bits) with the slot's generation
+// (high bits), so a stale ID for a reused slot never matches the new request.
+#define RESPONSE_SLOT_BITS 12
+#define RESPONSE_SLOT_COUNT (1 << RESPONSE_SLOT_BITS)
+#define RESPONSE_SLOT_MASK (RESPONSE_SLOT_COUNT - 1)
+#define RESPONSE_GENERATION_MASK (0x7FFFFFFF >> RESPONSE_SLOT_BITS)
+
+typedef struct response_slot {
+    queued_request *request;    // Request awaiting a response, NULL when free
+    int generation;             // Bumped every time the slot is handed out
+    int next_free;              // Free list link (slot index, -1 terminates)
+} response_slot;
+
 
-// Mutexes for thread safety
 #ifdef _WIN32
-#include <windows.h>
-static CRITICAL_SECTION g_request_mutex;
-static CRITICAL_SECTION g_response_mutex;
-static CRITICAL_SECTION g_websocket_mutex;
-static int g_mutexes_initialized = 0;
-
-static void init_mutexes() {
-    if (!g_mutexes_initialized) {
-        InitializeCriticalSection(&g_request_mutex);
-        InitializeCriticalSection(&g_response_mutex);
-        InitializeCriticalSection(&g_websocket_mutex);
-        g_mutexes_initialized = 1;
-        printf("[CivetWebNative] Mutexes initialized\n");
-        fflush(stdout);
-    }
-}
-
-static void lock_request_mutex() { EnterCriticalSection(&g_request_mutex); }
-static void unlock_request_mutex() { LeaveCriticalSection(&g_request_mutex); }
-static void lock_response_mutex() { EnterCriticalSection(&g_response_mutex); }
-static void unlock_response_mutex() { LeaveCriticalSection(&g_response_mutex); }
-static void lock_websocket_mutex() { EnterCriticalSection(&g_websocket_mutex); }
-static void unlock_websocket_mutex() { LeaveCriticalSection(&g_websocket_mutex); }
+// Queue state lives in each server handle; only native tracing and the node pool are process-wide
+static hl_mutex g_trace_mutex;
+static hl_mutex g_pool_mutex;
+static int g_process_mutexes_initialized = 0;
+
+static void init_process_mutexes() {
+    if (!g_process_mutexes_initialized) {
+        InitializeCriticalSection(&g_trace_mutex);
+        InitializeCriticalSection(&g_pool_mutex);
+        g_process_mutexes_initialized = 1;
+    }
+}
+
+static void mutex_init(hl_mutex *m) { InitializeCriticalSection(m); }
+static void mutex_destroy(hl_mutex *m) { DeleteCriticalSection(m); }
+static void mutex_lock(hl_mutex *m) { EnterCriticalSection(m); }
+static void mutex_unlock(hl_mutex *m) { LeaveCriticalSection(m); }
+
+static void cond_init(hl_cond *c) { InitializeConditionVariable(c); }
+static void cond_destroy(hl_cond *c) { (void)c; }
+static void cond_signal(hl_cond *c) { WakeConditionVariable(c); }
+static void cond_broadcast(hl_cond *c) { WakeAllConditionVariable(c); }
+
+// Monotonic clock in milliseconds
+static long long now_ms() { return (long long)GetTickCount64(); }
+
+// Monotonic clock in microseconds (for latency histograms)
+static long long now_us() {
+    static LARGE_INTEGER frequency;
+    LARGE_INTEGER counter;
+    if (!frequency.QuadPart) QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+    return (long long)(counter.QuadPart / frequency.QuadPart * 1000000
+        + counter.QuadPart % frequency.QuadPart * 1000000 / frequency.QuadPart);
+}
+
+// Wait on a condition with its mutex held. Returns 0 if signaled, non-zero on timeout.
+static int cond_wait(hl_cond *c, hl_mutex *m, long long timeout_ms) {
+    return SleepConditionVariableCS(c, m, (DWORD)timeout_ms) ? 0 : 1;
+}
+
+// Atomics for the lock-free WebSocket event ring, trace rings and latency histograms
+static long long atomic_load_acquire(atomic_counter *p) { long long v = *p; MemoryBarrier(); return v; }
+static void atomic_store_release(atomic_counter *p, long long v) { MemoryBarrier(); *p = v; }
+static int atomic_cas(atomic_counter *p, long long expected, long long desired) {
+    return InterlockedCompareExchange64(p, desired, expected) == expected;
+}
+static void atomic_add(atomic_counter *p, long long v) { InterlockedExchangeAdd64(p, v); }
+static long long atomic_exchange(atomic_counter *p, long long v) { return InterlockedExchange64(p, v); }
+static int highest_bit(unsigned long long v) { unsigned long i; _BitScanReverse64(&i, v); return (int)i; }
+static void thread_yield() { SwitchToThread(); }
 #else
-#include <pthread.h>
-static pthread_mutex_t g_request_mutex = PTHREAD_MUTEX_INITIALIZER;
-static pthread_mutex_t g_response_mutex = PTHREAD_MUTEX_INITIALIZER;
-static pthread_mutex_t g_websocket_mutex = PTHREAD_MUTEX_INITIALIZER;
+// Queue state lives in each server handle; only native tracing and the node pool are process-wide
+static hl_mutex g_trace_mutex = PTHREAD_MUTEX_INITIALIZER;
+static hl_mutex g_pool_mutex = PTHREAD_MUTEX_INITIALIZER;
 
-static void init_mutexes() {
+static void init_process_mutexes() {
     // Already initialized statically
 }
 
-static void lock_request_mutex() { pthread_mutex_lock(&g_request_mutex); }
-static void unlock_request_mutex() { pthread_mutex_unlock(&g_request_mutex); }
-static void lock_response_mutex() { pthread_mutex_lock(&g_response_mutex); }
-static void unlock_response_mutex() { pthread_mutex_unlock(&g_response_mutex); }
-static void lock_websocket_mutex() { pthread_mutex_lock(&g_websocket_mutex); }
-static void unlock_websocket_mutex() { pthread_mutex_unlock(&g_websocket_mutex); }
+static void mutex_init(hl_mutex *m) { pthread_mutex_init(m, NULL); }
+static void mutex_destroy(hl_mutex *m) { pthread_mutex_destroy(m); }
+static void mutex_lock(hl_mutex *m) { pthread_mutex_lock(m); }
+static void mutex_unlock(hl_mutex *m) { pthread_mutex_unlock(m); }
+
+static void cond_init(hl_cond *c) { pthread_cond_init(c, NULL); }
+static void cond_destroy(hl_cond *c) { pthread_cond_destroy(c); }
+static void cond_signal(hl_cond *c) { pthread_cond_signal(c); }
+static void cond_broadcast(hl_cond *c) { pthread_cond_broadcast(c); }
+
+// Monotonic clock in milliseconds
+static long long now_ms() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+// Monotonic clock in microseconds (for latency histograms)
+static long long now_us() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+// Helper: Absolute CLOCK_REALTIME deadline timeout_ms from now, as pthread_cond_timedwait expects
+static struct timespec realtime_deadline(long long timeout_ms) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    ts.tv_sec += (time_t)(timeout_ms / 1000);
+    ts.tv_nsec += (long)(timeout_ms % 1000) * 1000000;
+    if (ts.tv_nsec >= 1000000000) {
+        ts.tv_sec++;
+        ts.tv_nsec -= 1000000000;
+    }
+    return ts;
+}
+
+// Wait on a condition with its mutex held. Returns 0 if signaled, non-zero on timeout.
+static int cond_wait(hl_cond *c, hl_mutex *m, long long timeout_ms) {
+    struct timespec ts = realtime_deadline(timeout_ms);
+    return pthread_cond_timedwait(c, m, &ts);
+}
+
+// Atomics for the lock-free WebSocket event ring, trace rings and latency histograms
+static long long atomic_load_acquire(atomic_counter *p) { return __atomic_load_n(p, __ATOMIC_ACQUIRE); }
+static void atomic_store_release(atomic_counter *p, long long v) { __atomic_store_n(p, v, __ATOMIC_RELEASE); }
+static int atomic_cas(atomic_counter *p, long long expected, long long desired) {
+    return __atomic_compare_exchange_n(p, &expected, desired, 0, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED);
+}
+static void atomic_add(atomic_counter *p, long long v) { __atomic_fetch_add(p, v, __ATOMIC_RELAXED); }
+static long long atomic_exchange(atomic_counter *p, long long v) { return __atomic_exchange_n(p, v, __ATOMIC_ACQ_REL); }
+static int highest_bit(unsigned long long v) { return 63 - __builtin_clzll(v); }
+static void thread_yield() { sched_yield(); }
 #endif
 
-// Helper: Enqueue WebSocket event
-static void enqueue_websocket_event(int type, struct mg_connection *conn, int flags, const char *data, int data_len) {
-    queued_websocket_event *evt = (queued_websocket_event*)malloc(sizeof(queued_websocket_event));
-    if (!evt) return;
-    
-    evt->type = type;
-    evt->conn = conn;
-    evt->flags = flags;
-    evt->next = NULL;
-    
-    if (data && data_len > 0) {
-        evt->data = (char*)malloc(data_len + 1);
-        if (evt->data) {
-            memcpy(evt->data, data, data_len);
-            evt->data[data_len] = '\0';
-            evt->data_len = data_len;
+// Node pool: requests, responses, stream chunks and WebSocket payloads are allocated on one
+// thread and freed on another at request rate. Blocks up to POOL_MAX_SIZE are rounded up to a
+// power of two and recycled instead of going back to malloc: each thread keeps a small cache
+// per size class (no lock) and trades whole batches with a shared depot (one lock per batch).
+#define POOL_MIN_SHIFT 7                        // Smallest class: 128 bytes, header included
+#define POOL_CLASS_COUNT 10                     // 128 B .. 64 KB
+#define POOL_MAX_SIZE ((size_t)1 << (POOL_MIN_SHIFT + POOL_CLASS_COUNT - 1))
+#define POOL_OVERSIZE POOL_CLASS_COUNT          // size_class of blocks too large to pool (plain malloc)
+#define POOL_BATCH 16                           // Blocks moved between a thread cache and the depot at once
+#define DEFAULT_POOL_LIMIT (4 * 1024 * 1024)    // Bytes per class the depot keeps; the rest goes back to malloc
+
+typedef struct pool_block {
+    struct pool_block *next;            // Free list link while cached
+    int size_class;                     // Index into g_pool, or POOL_OVERSIZE
+} pool_block;
+
+typedef struct pool_class {
+    pool_block *depot;                  // Free blocks shared by all threads (guarded by g_pool_mutex)
+    int depot_count;
+    atomic_counter live;                // Blocks taken from malloc and not yet returned to it
+    atomic_counter high_water;          // Most blocks live at once
+    atomic_counter mallocs;             // Times the pool had to call malloc
+} pool_class;
+
+typedef struct pool_cache {
+    pool_block *blocks[POOL_CLASS_COUNT];
+    int counts[POOL_CLASS_COUNT];
+} pool_cache;
+
+static pool_class g_pool[POOL_CLASS_COUNT + 1];    // The last entry counts oversize blocks
+static volatile int g_pool_limit = DEFAULT_POOL_LIMIT;
+static THREAD_LOCAL pool_cache t_pool_cache;
+
+// Helper: Size class holding size bytes (header included), or POOL_OVERSIZE
+static int pool_class_for(size_t size) {
+    if (size > POOL_MAX_SIZE) return POOL_OVERSIZE;
+    if (size <= ((size_t)1 << POOL_MIN_SHIFT)) return 0;
+    return highest_bit((unsigned long long)(size - 1)) + 1 - POOL_MIN_SHIFT;
+}
+
+// Helper: Count a block taken from malloc and raise the class's high-water mark
+static void pool_count_malloc(pool_class *pc) {
+    atomic_add(&pc->mallocs, 1);
+    atomic_add(&pc->live, 1);
+    long long live = atomic_load_acquire(&pc->live);
+    long long high = atomic_load_acquire(&pc->high_water);
+    while (live > high && !atomic_cas(&pc->high_water, high, live)) {
+        high = atomic_load_acquire(&pc->high_water);
+    }
+}
+
+// Helper: Move up to POOL_BATCH free blocks from the depot into this thread's cache
+static void pool_refill(pool_cache *cache, int cls) {
+    pool_class *pc = &g_pool[cls];
+    mutex_lock(&g_pool_mutex);
+    for (int i = 0; i < POOL_BATCH && pc->depot; i++) {
+        pool_block *block = pc->depot;
+        pc->depot = block->next;
+        pc->depot_count--;
+        block->next = cache->blocks[cls];
+        cache->blocks[cls] = block;
+        cache->counts[cls]++;
+    }
+    mutex_unlock(&g_pool_mutex);
+}
+
+// Helper: Move count blocks from this thread's cache to the depot. Blocks past the depot's
+// limit (g_pool_limit bytes per class) are freed, so a burst does not pin memory for good.
+static void pool_spill(pool_cache *cache, int cls, int count) {
+    pool_class *pc = &g_pool[cls];
+    int limit = g_pool_limit >> (cls + POOL_MIN_SHIFT);
+    pool_block *excess = NULL;
+    mutex_lock(&g_pool_mutex);
+    for (int i = 0; i < count && cache->blocks[cls]; i++) {
+        pool_block *block = cache->blocks[cls];
+        cache->blocks[cls] = block->next;
+        cache->counts[cls]--;
+        if (pc->depot_count < limit) {
+            block->next = pc->depot;
+            pc->depot = block;
+            pc->depot_count++;
         } else {
-            evt->data = NULL;
-            evt->data_len = 0;
+            block->next = excess;
+            excess = block;
         }
+    }
+    mutex_unlock(&g_pool_mutex);
+
+    while (excess) {
+        pool_block *next = excess->next;
+        free(excess);
+        atomic_add(&pc->live, -1);
+        excess = next;
+    }
+}
+
+// Helper: malloc replacement for queue nodes and payload buffers; release with pool_free
+static void* pool_alloc(size_t size) {
+    int cls = pool_class_for(size + sizeof(pool_block));
+    pool_block *block = NULL;
+    if (cls != POOL_OVERSIZE) {
+        pool_cache *cache = &t_pool_cache;
+        if (!cache->blocks[cls]) pool_refill(cache, cls);
+        block = cache->blocks[cls];
+        if (block) {
+            cache->blocks[cls] = block->next;
+            cache->counts[cls]--;
+        }
+    }
+    if (!block) {
+        size_t block_size = cls == POOL_OVERSIZE ? sizeof(pool_block) + size : (size_t)1 << (cls + POOL_MIN_SHIFT);
+        block = (pool_block*)malloc(block_size);
+        if (!block) return NULL;
+        pool_count_malloc(&g_pool[cls]);
+    }
+    block->size_class = cls;
+    return block + 1;
+}
+
+// Helper: Release a block from pool_alloc (from any thread)
+static void pool_free(void *ptr) {
+    if (!ptr) return;
+    pool_block *block = (pool_block*)ptr - 1;
+    int cls = block->size_class;
+    if (cls == POOL_OVERSIZE) {
+        free(block);
+        atomic_add(&g_pool[POOL_OVERSIZE].live, -1);
+        return;
+    }
+    pool_cache *cache = &t_pool_cache;
+    block->next = cache->blocks[cls];
+    cache->blocks[cls] = block;
+    if (++cache->counts[cls] >= 2 * POOL_BATCH) pool_spill(cache, cls, POOL_BATCH);
+}
+
+// Helper: Hand this thread's cached blocks to the depot (the thread is exiting)
+static void pool_flush_thread_cache() {
+    for (int cls = 0; cls < POOL_CLASS_COUNT; cls++) {
+        if (t_pool_cache.counts[cls] > 0) pool_spill(&t_pool_cache, cls, t_pool_cache.counts[cls]);
+    }
+}
+
+// Native tracing: each thread appends fixed-size binary events to a ring of its own (single
+// producer, so no lock or shared cache line on the hot path), and Haxe drains every ring into
+// HybridLogger with drain_trace. Events below g_trace_level are rejected by one integer compare.
+#define TRACE_DEBUG 0
+#define TRACE_INFO 1
+#define TRACE_WARN 2
+#define TRACE_ERROR 3
+#define TRACE_OFF 4
+
+// Event codes; format_trace_event turns each one into its message
+#define TRACE_SERVER_CREATED 0
+#define TRACE_UNKNOWN_OPTION 1
+#define TRACE_REQUEST_HANDLED 2
+#define TRACE_STREAM_CUT_SHORT 3
+#define TRACE_REQUEST_POLLED 4
+#define TRACE_RESPONSE_PUSHED 5
+#define TRACE_RESPONSE_DROPPED 6
+#define TRACE_EVENTS_DROPPED 7
+#define TRACE_WS_EVENT_DROPPED 8
+
+
+#define TRACE_RING_SIZE 256
+#define TRACE_RING_MASK (TRACE_RING_SIZE - 1)
+#define TRACE_TEXT_SIZE 40
+
+typedef struct trace_event {
+    long long time_ms;
+    int level;
+    int code;
+    int request_id;
+    int arg;
+    char text[TRACE_TEXT_SIZE];     // Truncated copy of the event's string argument
+} trace_event;
+
+typedef struct trace_ring {
+    atomic_counter head;            // Next slot to write (owner thread)
+    atomic_counter tail;            // Next slot to drain (drain_trace)
+    atomic_counter dropped;         // Events lost to a full ring (owner thread)
+    long long dropped_reported;     // Part of dropped already drained
+    atomic_counter in_use;          // 1 while a thread owns the ring; idle rings are adopted by new threads
+    struct trace_ring *next;
+    trace_event events[TRACE_RING_SIZE];
+} trace_ring;
+
+static volatile int g_trace_level = TRACE_WARN;
+static trace_ring *g_trace_rings = NULL;        // Every ring ever created; never freed (guarded by g_trace_mutex)
+static THREAD_LOCAL trace_ring *t_trace_ring = NULL;
+
+#define trace_enabled(level) ((level) >= g_trace_level)
+
+// Helper: This thread's ring, adopting an idle one or allocating it on first use
+static trace_ring* acquire_trace_ring() {
+    if (t_trace_ring) return t_trace_ring;
+    mutex_lock(&g_trace_mutex);
+    trace_ring *ring = g_trace_rings;
+    while (ring && !atomic_cas(&ring->in_use, 0, 1)) ring = ring->next;
+    if (!ring) {
+        ring = (trace_ring*)calloc(1, sizeof(trace_ring));
+        if (ring) {
+            ring->in_use = 1;
+            ring->next = g_trace_rings;
+            g_trace_rings = ring;
+        }
+    }
+    mutex_unlock(&g_trace_mutex);
+    t_trace_ring = ring;
+    return ring;
+}
+
+// Helper: Hand this thread's ring back for reuse (its pending events can still be drained)
+static void release_trace_ring() {
+    if (!t_trace_ring) return;
+    atomic_store_release(&t_trace_ring->in_use, 0);
+    t_trace_ring = NULL;
+}
+
+// Helper: Record an event; use through trace() so disabled levels cost a single compare
+static void trace_write(int level, int code, int request_id, int arg, const char *text) {
+    trace_ring *ring = acquire_trace_ring();
+    if (!ring) return;
+    long long head = ring->head;
+    if (head - atomic_load_acquire(&ring->tail) >= TRACE_RING_SIZE) {
+        atomic_store_release(&ring->dropped, ring->dropped + 1);
+        return;
+    }
+    trace_event *evt = &ring->events[head & TRACE_RING_MASK];
+    evt->time_ms = now_ms();
+    evt->level = level;
+    evt->code = code;
+    evt->request_id = request_id;
+    evt->arg = arg;
+    evt->text[0] = '\0';
+    if (text) {
+        strncpy(evt->text, text, TRACE_TEXT_SIZE - 1);
+        evt->text[TRACE_TEXT_SIZE - 1] = '\0';
+    }
+    atomic_store_release(&ring->head, head + 1);
+}
+
+#define trace(level, code, request_id, arg, text) \
+    do { if (trace_enabled(level)) trace_write((level), (code), (request_id), (arg), (text)); } while (0)
+
+// Helper: Render an event's message; formatting is deferred to the drain so producers only copy
+static void format_trace_event(const trace_event *evt, char *buf, size_t size) {
+    switch (evt->code) {
+        case TRACE_SERVER_CREATED: snprintf(buf, size, "Server handle created (build %s)", evt->text); break;
+        case TRACE_UNKNOWN_OPTION: snprintf(buf, size, "Unknown option '%s' ignored", evt->text); break;
+        case TRACE_REQUEST_HANDLED: snprintf(buf, size, "Handled request %d: %s (body length: %d)", evt->request_id, evt->text, evt->arg); break;
+        case TRACE_STREAM_CUT_SHORT: snprintf(buf, size, "Stream for request %d cut short", evt->request_id); break;
+        case TRACE_REQUEST_POLLED: snprintf(buf, size, "Polling request ID %d", evt->request_id); break;
+        case TRACE_RESPONSE_PUSHED: snprintf(buf, size, "Pushing response for ID %d (len %d)", evt->request_id, evt->arg); break;
+        case TRACE_RESPONSE_DROPPED: snprintf(buf, size, "Response for ID %d dropped (request no longer waiting)", evt->request_id); break;
+        case TRACE_EVENTS_DROPPED: snprintf(buf, size, "%d trace events dropped (ring full)", evt->arg); break;
+        case TRACE_WS_EVENT_DROPPED: snprintf(buf, size, "WebSocket event %d for connection %d dropped (%s)", evt->arg, evt->request_id, evt->text); break;
+        default: snprintf(buf, size, "Trace event %d", evt->code); break;
+    }
+}
+
+// Helper: Copy one event into a caller-provided record
+static void fill_trace_event(hl_trace_event *record, const trace_event *evt, long long now) {
+    char message[128];
+    format_trace_event(evt, message, sizeof(message));
+    record->level = evt->level;
+    record->code = evt->code;
+    record->request_id = evt->request_id;
+    record->age_ms = (int)(now - evt->time_ms);
+    record->message = hl_copy_bytes((const vbyte*)message, (int)strlen(message) + 1);
+}
+
+// CivetWeb callback: a worker or service thread is exiting
+static void exit_thread_handler(const struct mg_context *ctx, int thread_type, void *thread_pointer) {
+    release_trace_ring();
+    pool_flush_thread_cache();
+}
+
+// Latency histograms: every request is timestamped as it passes each stage, and the duration
+// is counted in a log-linear histogram (HDR style: 8 sub-buckets per power of two, so any
+// reported value is within 12.5% of the true one). Counters are atomic; recording never locks.
+#define STAGE_QUEUE_WAIT 0      // Enqueued until poll_requests hands the request to Haxe
+#define STAGE_POLL_INTERVAL 1   // Gap between polls of a queue: the main loop's (or an island's) cadence
+#define STAGE_PROCESSING 2      // Polled until Haxe pushes the response (dispatch + island)
+#define STAGE_RESPONSE_WAIT 3   // Response pushed until its worker wakes up to send it
+#define STAGE_WRITE 4           // Status line, headers and body written with mg_write
+#define STAGE_TOTAL 5           // Handler entry to the last byte written (buffered responses)
+#define STAGE_COUNT 6
+
+#define LATENCY_SUB_BITS 3
+#define LATENCY_SUB_COUNT (1 << LATENCY_SUB_BITS)
+#define LATENCY_MAX_BITS 40     // Values are clamped to 2^40 us (about 12 days)
+#define LATENCY_BUCKETS ((LATENCY_MAX_BITS - LATENCY_SUB_BITS + 1) * LATENCY_SUB_COUNT)
+
+typedef struct latency_histogram {
+    atomic_counter counts[LATENCY_BUCKETS];
+    atomic_counter total;
+    atomic_counter sum_us;
+    atomic_counter max_us;
+} latency_histogram;
+
+
+// Helper: Bucket holding a duration in microseconds
+static int latency_bucket(long long us) {
+    if (us < LATENCY_SUB_COUNT) return us < 0 ? 0 : (int)us;
+    if (us >= (1LL << LATENCY_MAX_BITS)) us = (1LL << LATENCY_MAX_BITS) - 1;
+    int exponent = highest_bit((unsigned long long)us);
+    int shift = exponent - LATENCY_SUB_BITS;
+    return (shift + 1) * LATENCY_SUB_COUNT + (int)((us >> shift) - LATENCY_SUB_COUNT);
+}
+
+// Helper: Largest duration that falls in a bucket
+static long long latency_bucket_limit(int bucket) {
+    if (bucket < LATENCY_SUB_COUNT) return bucket;
+    int shift = bucket / LATENCY_SUB_COUNT - 1;
+    long long low = (long long)(LATENCY_SUB_COUNT + bucket % LATENCY_SUB_COUNT) << shift;
+    return low + (1LL << shift) - 1;
+}
+
+// Helper: Count one duration for a stage in a server's histograms (any thread)
+static void record_latency(latency_histogram *latency, int stage, long long us) {
+    if (us < 0) us = 0;
+    latency_histogram *h = &latency[stage];
+    atomic_add(&h->counts[latency_bucket(us)], 1);
+    atomic_add(&h->total, 1);
+    atomic_add(&h->sum_us, us);
+    long long max = atomic_load_acquire(&h->max_us);
+    while (us > max && !atomic_cas(&h->max_us, max, us)) {
+        max = atomic_load_acquire(&h->max_us);
+    }
+}
+
+// Helper: Summarize a stage into a Haxe record, optionally starting a new interval.
+// Recording continues concurrently, so a reset may lose or split a few in-flight samples.
+static void snapshot_latency(latency_histogram *latency, int stage, hl_stage_stats *stats, int reset) {
+    latency_histogram *h = &latency[stage];
+    long long counts[LATENCY_BUCKETS];
+    long long total = 0;
+    for (int i = 0; i < LATENCY_BUCKETS; i++) {
+        counts[i] = reset ? atomic_exchange(&h->counts[i], 0) : atomic_load_acquire(&h->counts[i]);
+        total += counts[i];
+    }
+    long long sum = reset ? atomic_exchange(&h->sum_us, 0) : atomic_load_acquire(&h->sum_us);
+    long long max = reset ? atomic_exchange(&h->max_us, 0) : atomic_load_acquire(&h->max_us);
+    if (reset) atomic_exchange(&h->total, 0);
+
+    static const double quantiles[] = { 0.5, 0.9, 0.99, 0.999 };
+    int values[4] = { 0, 0, 0, 0 };
+    long long seen = 0;
+    int q = 0;
+    for (int i = 0; i < LATENCY_BUCKETS && q < 4 && total > 0; i++) {
+        seen += counts[i];
+        while (q < 4 && seen >= (long long)(quantiles[q] * (double)total + 0.5) && seen > 0) {
+            long long limit = latency_bucket_limit(i);
+            if (limit > max) limit = max;
+            values[q++] = limit > 0x7FFFFFFF ? 0x7FFFFFFF : (int)limit;
+        }
+    }
+
+    stats->count = (double)total;
+    stats->sum_us = (double)sum;
+    stats->p50_us = values[0];
+    stats->p90_us = values[1];
+    stats->p99_us = values[2];
+    stats->p999_us = values[3];
+    stats->max_us = max > 0x7FFFFFFF ? 0x7FFFFFFF : (int)max;
+}
+
+// WebSocket events travel through a preallocated bounded ring (Vyukov's MPMC queue):
+// CivetWeb threads claim cells with a CAS on the enqueue position instead of sharing a lock,
+// and payloads up to WS_EVENT_INLINE_SIZE bytes are stored in the cell itself.
+#define WS_RING_BITS 12
+#define WS_RING_SIZE (1 << WS_RING_BITS)
+#define WS_RING_MASK (WS_RING_SIZE - 1)
+#define WS_EVENT_INLINE_SIZE 200
+#define WS_RING_FULL_WAIT_MS 1000   // Longest a producer waits for room before the event is dropped
+
+typedef struct ws_ring_cell {
+    atomic_counter sequence;    // Cell state: == pos when free for enqueue, == pos + 1 when full
+    int type;
+    int flags;
+    int data_len;
+    int conn_id;
+    char *overflow;             // Heap copy for payloads larger than the inline buffer
+    char data[WS_EVENT_INLINE_SIZE + 1];
+} ws_ring_cell;
+
+typedef struct ws_ring {
+    atomic_counter enqueue_pos;
+    atomic_counter dequeue_pos;
+    ws_ring_cell cells[WS_RING_SIZE];
+} ws_ring;
+
+// Helper: Number each cell with its first position (call once, before any WebSocket can connect)
+static void init_websocket_ring(ws_ring *ring) {
+    ring->enqueue_pos = 0;
+    ring->dequeue_pos = 0;
+    for (long long i = 0; i < WS_RING_SIZE; i++) {
+        atomic_store_release(&ring->cells[i].sequence, i);
+    }
+}
+
+// Helper: Enqueue WebSocket event (called from CivetWeb threads, lock-free).
+// When the ring is full the producer yields until Haxe drains it, so a slow consumer throttles
+// the sockets, but for no longer than WS_RING_FULL_WAIT_MS and not at all once *stopping is set.
+// Returns NULL if queued, otherwise why the event was dropped (the caller decides what that means).
+static const char* enqueue_websocket_event(ws_ring *ring, volatile int *stopping, int type, int conn_id, int flags, const char *data, int data_len) {
+    char *overflow = NULL;
+    if (data && data_len > WS_EVENT_INLINE_SIZE) {
+        overflow = (char*)pool_alloc((size_t)data_len + 1);
+        if (!overflow) return "out of memory";
+        memcpy(overflow, data, (size_t)data_len);
+        overflow[data_len] = '\0';
+    }
+
+    ws_ring_cell *cell;
+    long long give_up_ms = 0;
+    long long pos = atomic_load_acquire(&ring->enqueue_pos);
+    for (;;) {
+        cell = &ring->cells[pos & WS_RING_MASK];
+        long long diff = atomic_load_acquire(&cell->sequence) - pos;
+        if (diff == 0) {
+            if (atomic_cas(&ring->enqueue_pos, pos, pos + 1)) break;
+            pos = atomic_load_acquire(&ring->enqueue_pos);
+        } else if (diff < 0) {
+            long long now = now_ms();
+            if (give_up_ms == 0) give_up_ms = now + WS_RING_FULL_WAIT_MS;
+            if (*stopping || now >= give_up_ms) {
+                if (overflow) pool_free(overflow);
+                return "event ring full";
+            }
+            thread_yield();
+            pos = atomic_load_acquire(&ring->enqueue_pos);
+        } else {
+            pos = atomic_load_acquire(&ring->enqueue_pos);
+        }
+    }
+
+    cell->type = type;
+    cell->conn_id = conn_id;
+    cell->flags = flags;
+    cell->overflow = overflow;
+    cell->data_len = data ? data_len : 0;
+    if (data && !overflow && data_len > 0) {
+        memcpy(cell->data, data, (size_t)data_len);
+    }
+    cell->data[overflow ? 0 : cell->data_len] = '\0';
+    atomic_store_release(&cell->sequence, pos + 1);
+    return NULL;
+}
+
+// Helper: Claim the oldest full cell, or NULL if the ring is empty. The cell must be
+// handed back with release_websocket_cell once read.
+static ws_ring_cell* claim_websocket_cell(ws_ring *ring, long long *claimed_pos) {
+    long long pos = atomic_load_acquire(&ring->dequeue_pos);
+    for (;;) {
+        ws_ring_cell *cell = &ring->cells[pos & WS_RING_MASK];
+        long long diff = atomic_load_acquire(&cell->sequence) - (pos + 1);
+        if (diff == 0) {
+            if (atomic_cas(&ring->dequeue_pos, pos, pos + 1)) {
+                *claimed_pos = pos;
+                return cell;
+            }
+            pos = atomic_load_acquire(&ring->dequeue_pos);
+        } else if (diff < 0) {
+            return NULL;
+        } else {
+            pos = atomic_load_acquire(&ring->dequeue_pos);
+        }
+    }
+}
+
+// Helper: Free a read cell for reuse by producers one lap later
+static void release_websocket_cell(ws_ring_cell *cell, long long pos) {
+    if (cell->overflow) {
+        pool_free(cell->overflow);
+        cell->overflow = NULL;
+    }
+    atomic_store_release(&cell->sequence, pos + WS_RING_SIZE);
+}
+
+// Helper: Copy a claimed cell into a Haxe event record
+static void fill_websocket_event(hl_websocket_event *evt, ws_ring_cell *cell) {
+    evt->type = cell->type;
+    evt->flags = cell->flags;
+    evt->conn_id = cell->conn_id;
+    evt->data_length = cell->data_len;
+    if (cell->data_len > 0) {
+        const char *payload = cell->overflow ? cell->overflow : cell->data;
+        evt->data = hl_copy_bytes((const vbyte*)payload, cell->data_len + 1);
     } else {
         evt->data = NULL;
-        evt->data_len = 0;
     }
-    
-    lock_websocket_mutex();
-    if (g_websocket_queue_tail) {
-        g_websocket_queue_tail->next = evt;
-    } else {
-        g_websocket_queue_head = evt;
+}
+
+static size_t request_headers_size(const struct mg_request_info *request_info);
+static void copy_request_headers(char **cursor, const struct mg_request_info *request_info);
+
+// WebSocket connections are handed to Haxe as ids rather than raw mg_connection pointers:
+// CivetWeb reuses a worker's connection struct for the next client, so a pointer kept past
+// onClose could write to someone else's socket. Ids increase monotonically (wrapping only
+// after INT_MAX connections) and index the handle table by their low bits; a send validates
+// and pins the id under the handle table's mutex, then writes without it, so sends after close
+// are cheap no-ops and a slow client only stalls its own sender. Closing waits for the pins to
+// drop before the connection can be recycled. Each server has a table of its own, so ids are
+// only meaningful together with their server.
+#define WS_HANDLE_BITS 16
+#define WS_HANDLE_COUNT (1 << WS_HANDLE_BITS)
+#define WS_HANDLE_MASK (WS_HANDLE_COUNT - 1)
+
+typedef struct ws_handle {
+    int id;                         // 0 when the handle is free
+    int decision;                   // Handshake verdict: 0 pending, 1 accepted, -1 rejected
+    int ready;                      // Upgrade response sent (websocket_ready_handler); sends wait for it
+    int pins;                       // Sends writing to conn right now; unregister waits for them
+    int awaiting;                   // Counted in the table's pending handshakes
+    struct mg_connection *conn;
+} ws_handle;
+
+typedef struct ws_handle_table {
+    hl_mutex mutex;                 // Guards the handles; never held across a socket write
+    hl_cond decided;                // Signaled when Haxe accepts or rejects a handshake
+    hl_cond unpinned;               // Signaled when a handle's last pin is dropped
+    int next_id;
+    int count;                      // Open connections
+    int pending;                    // Handshakes holding a worker while they wait for Haxe's verdict
+    int max_pending;
+    ws_handle handles[WS_HANDLE_COUNT];
+} ws_handle_table;
+
+// Helper: Stop counting a handle as a pending handshake (the table's mutex must be held)
+static void settle_websocket_handshake(ws_handle_table *table, ws_handle *handle) {
+    if (handle->awaiting) {
+        handle->awaiting = 0;
+        table->pending--;
+    }
+}
+
+// Helper: Issue the next free connection id for conn, as a pending handshake. Returns 0 if
+// every handle is in use, or -1 if max_pending handshakes are already waiting for Haxe.
+static int register_websocket(ws_handle_table *table, struct mg_connection *conn) {
+    int id = 0;
+    mutex_lock(&table->mutex);
+    if (table->pending >= table->max_pending) {
+        id = -1;
+    } else if (table->count < WS_HANDLE_COUNT) {
+        // Skip ids whose handle is still held by a long-lived connection
+        do {
+            id = table->next_id;
+            table->next_id = (id == 0x7FFFFFFF) ? 1 : id + 1;
+        } while (table->handles[id & WS_HANDLE_MASK].id != 0);
+        table->handles[id & WS_HANDLE_MASK].id = id;
+        table->handles[id & WS_HANDLE_MASK].decision = 0;
+        table->handles[id & WS_HANDLE_MASK].ready = 0;
+        table->handles[id & WS_HANDLE_MASK].pins = 0;
+        table->handles[id & WS_HANDLE_MASK].awaiting = 1;
+        table->handles[id & WS_HANDLE_MASK].conn = conn;
+        table->count++;
+        table->pending++;
     }
-    g_websocket_queue_tail = evt;
-    unlock_websocket_mutex();
+    mutex_unlock(&table->mutex);
+    return id;
 }
 
-// WebSocket callback: connection established
+// Helper: Invalidate a connection id, waiting out any send still writing to it (see
+// pin_websocket). Only ready handles can be pinned, and those are always released from the
+// WebSocket close handler, which runs without CivetWeb's connection lock; connection_close_handler
+// (which holds it) only ever sees handles that never became ready, so it never waits here.
+static void unregister_websocket(ws_handle_table *table, int id) {
+    mutex_lock(&table->mutex);
+    ws_handle *handle = &table->handles[id & WS_HANDLE_MASK];
+    if (id > 0 && handle->id == id) {
+        handle->ready = 0;
+        while (handle->pins > 0) cond_wait(&table->unpinned, &table->mutex, 1000);
+    }
+    if (id > 0 && handle->id == id) {
+        settle_websocket_handshake(table, handle);
+        handle->id = 0;
+        handle->conn = NULL;
+        table->count--;
+    }
+    mutex_unlock(&table->mutex);
+}
+
+// Helper: Let sends through on an accepted id now that its upgrade response has gone out
+static void mark_websocket_ready(ws_handle_table *table, int id) {
+    mutex_lock(&table->mutex);
+    ws_handle *handle = &table->handles[id & WS_HANDLE_MASK];
+    if (handle->id == id) handle->ready = 1;
+    mutex_unlock(&table->mutex);
+}
+
+// Helper: Connection for a live id (the table's mutex must be held), or NULL if it has closed
+// or its handshake has not completed yet (a frame must never precede the 101 response)
+static struct mg_connection* lookup_websocket(ws_handle_table *table, int id) {
+    if (id <= 0) return NULL;
+    ws_handle *handle = &table->handles[id & WS_HANDLE_MASK];
+    return handle->id == id && handle->ready ? handle->conn : NULL;
+}
+
+// Helper: Connection for a live, ready id, kept from being recycled until unpin_websocket,
+// or NULL. The caller writes to it without holding the table's mutex.
+static struct mg_connection* pin_websocket(ws_handle_table *table, int id) {
+    mutex_lock(&table->mutex);
+    struct mg_connection *conn = lookup_websocket(table, id);
+    if (conn) table->handles[id & WS_HANDLE_MASK].pins++;
+    mutex_unlock(&table->mutex);
+    return conn;
+}
+
+// Helper: Release a pin taken by pin_websocket
+static void unpin_websocket(ws_handle_table *table, int id) {
+    mutex_lock(&table->mutex);
+    ws_handle *handle = &table->handles[id & WS_HANDLE_MASK];
+    if (--handle->pins == 0) cond_broadcast(&table->unpinned);
+    mutex_unlock(&table->mutex);
+}
+
+// Helper: Connection id stored on a WebSocket once its handshake was accepted (0 if none)
+static int websocket_id(const struct mg_connection *conn) {
+    return (int)(intptr_t)mg_get_user_connection_data(conn);
+}
+
+// Helper: Block until Haxe accepts or rejects a handshake (websocket_accept) or timeout_ms
+// passes. Returns 1 if accepted, -1 if rejected and 0 on timeout.
+static int await_websocket_decision(ws_handle_table *table, int id, int timeout_ms) {
+    long long deadline = now_ms() + timeout_ms;
+    ws_handle *handle = &table->handles[id & WS_HANDLE_MASK];
+    mutex_lock(&table->mutex);
+    while (handle->id == id && handle->decision == 0) {
+        long long remaining = deadline - now_ms();
+        if (remaining <= 0) break;
+        cond_wait(&table->decided, &table->mutex, remaining);
+    }
+    int decision = -1;
+    if (handle->id == id) {
+        decision = handle->decision;
+        settle_websocket_handshake(table, handle);
+    }
+    mutex_unlock(&table->mutex);
+    return decision;
+}
+
+struct hl_civetweb_server {
+    struct mg_context *ctx;
+    struct mg_callbacks callbacks;
+    char *document_root;
+    int port;
+    char *host;
+    int running;
+    volatile int stopping;        // stop() is draining requests and CivetWeb's workers; new requests get 503
+    char **options;               // CivetWeb options as name/value pairs, passed to mg_start
+    int num_options;              // Number of name/value pairs in options
+    long long max_body_size;      // Requests with a larger body are rejected with 413
+    int max_suspended;            // Requests that may be parked at once (see suspend_request)
+    int default_timeout_ms;       // How long a worker waits for Haxe unless a route sets its own timeout
+    int max_queue_depth;          // High-water mark: past this many unpolled requests, answer 503 (0 = unbounded)
+    route_timeout *route_timeouts;
+    int num_route_timeouts;
+    char num_threads[16];         // Worker pool size passed to CivetWeb, parking capacity included
+    char **websocket_paths;       // URI prefixes served by the WebSocket handlers ("/ws" if none are added)
+    int num_websocket_paths;
+    int websocket_accept_timeout_ms; // Handshakes Haxe has not accepted by then are refused
+    static_mount *static_mounts;  // Checked before any request is queued for Haxe (longest prefix wins)
+    int num_static_mounts;
+    int compress_min_size;        // Dynamic bodies at least this large are gzipped for clients that accept it (-1 = never)
+    int compress_level;           // zlib level, 1 (fastest) to 9 (smallest)
+    char **compress_types;        // Content-Type prefixes worth compressing (DEFAULT_COMPRESS_TYPES if none are added)
+    int num_compress_types;
+
+    // Queues and id counters are per server, so listeners on different ports (an admin or
+    // metrics port next to the public one) never share back-pressure, request ids or sockets
+    request_queue pending;        // Requests for poll_requests when there are no island queues
+    request_queue *island_queues; // One per WorkerIsland (see set_islands), picked by session_id cookie
+    int num_islands;
+    atomic_counter next_island;   // Round-robin cursor for requests without a session
+    atomic_counter queue_depth;   // Requests Haxe has not polled yet, across all queues
+    atomic_counter rejected_count; // Requests shed with 503 before reaching Haxe
+    atomic_counter ws_events_dropped; // WebSocket events lost to a full ring or failed allocation
+
+    hl_mutex response_mutex;
+    response_slot response_slots[RESPONSE_SLOT_COUNT];
+    int free_slot_head;           // Free list of response_slots (guarded by response_mutex, as is the rest)
+    int slots_used;               // Slots ever handed out; indexes beyond this are untouched
+    int suspended_count;          // Requests currently parked
+    int active_requests;          // Requests holding a response slot
+    int writing_responses;        // Answered requests whose worker is still writing to the socket
+    long long last_completion_us; // Admission control: how quickly Haxe completes requests while it has work
+    int active_at_last_completion;
+    atomic_counter completion_interval_us; // Moving average of the gap between completions (written under
+                                           // response_mutex, read lock-free by can_meet_deadline)
+    hl_cond drained;              // Signaled while stopping as requests release their slots or park
+
+    latency_histogram latency[STAGE_COUNT];
+    ws_ring ws_events;
+    ws_handle_table ws_handles;
+
+    // Main-loop wakeup (see wait_for_work): raised when a request reaches the shared queue or a
+    // WebSocket event is queued, cleared by the waiter. Only raising it from 0 locks or writes the fd.
+    atomic_counter work_signaled;
+    hl_mutex work_mutex;
+    hl_cond work_ready;
+    int wakeup_fds[2];                  // Read and write ends: one eventfd twice, or a pipe (-1 until get_wakeup_fd)
+};
+
+// Helper: Empty the wakeup fd so a poller sees it readable again only for new work
+static void drain_wakeup_fd(hl_civetweb_server *server) {
+#ifndef _WIN32
+    if (server->wakeup_fds[0] < 0) return;
+    char buf[64];
+    while (read(server->wakeup_fds[0], buf, sizeof(buf)) > 0) {}
+#endif
+}
+
+// Helper: Tell wait_for_work, and anything polling the wakeup fd, that the main loop has work
+static void signal_work(hl_civetweb_server *server) {
+    if (atomic_exchange(&server->work_signaled, 1)) return;
+    mutex_lock(&server->work_mutex);
+    cond_broadcast(&server->work_ready);
+    mutex_unlock(&server->work_mutex);
+#ifndef _WIN32
+    if (server->wakeup_fds[1] >= 0) {
+        unsigned long long one = 1;
+        ssize_t written = write(server->wakeup_fds[1], &one, sizeof(one));
+        (void)written;  // A full pipe is already readable
+    }
+#endif
+}
+
+// Helper: Queue a WebSocket event for poll_websocket_events and wake the main loop.
+// Returns 0 if it was queued, -1 if it was dropped (counted and traced); the caller should then
+// fail the handshake or close the connection, since Haxe will not hear about it.
+static int post_websocket_event(hl_civetweb_server *server, int type, int conn_id, int flags, const char *data, int data_len) {
+    const char *dropped = enqueue_websocket_event(&server->ws_events, &server->stopping, type, conn_id, flags, data, data_len);
+    if (dropped) {
+        atomic_add(&server->ws_events_dropped, 1);
+        trace(TRACE_WARN, TRACE_WS_EVENT_DROPPED, conn_id, type, dropped);
+        return -1;
+    }
+    signal_work(server);
+    return 0;
+}
+
+// Helper: Serialize an upgrade request for the CONNECT event: request URI, query string and
+// remote address on one line each, then the "Name: value\n" header block. Release with pool_free.
+static char* format_handshake(const struct mg_request_info *ri, int *length) {
+    const char *uri = ri->local_uri ? ri->local_uri : "";
+    const char *query = ri->query_string ? ri->query_string : "";
+    size_t size = strlen(uri) + strlen(query) + strlen(ri->remote_addr) + 3 + request_headers_size(ri);
+    char *handshake = (char*)pool_alloc(size);
+    if (!handshake) return NULL;
+    int n = snprintf(handshake, size, "%s\n%s\n%s\n", uri, query, ri->remote_addr);
+    char *cursor = handshake + n;
+    copy_request_headers(&cursor, ri);
+    *length = (int)(cursor - handshake);
+    return handshake;
+}
+
+// WebSocket callback: upgrade requested on one of the WebSocket paths. The handshake is
+// queued for Haxe with its metadata and this worker waits for the verdict, so rejected
+// sockets are refused before the upgrade completes.
 static int websocket_connect_handler(const struct mg_connection *conn, void *user_data) {
-    // Always accept connection (return 0)
-    // We notify Haxe via polling, but since handshake is synchronous in CivetWeb callbacks,
-    // we can't block here waiting for Haxe main thread. We assume accept.
-    // Ideally, we'd queue an event, but 'connect' event in CivetWeb is specifically for handshake decision.
-    // For now, we'll queue a CONNECT event to notify Haxe, but proceed with connection.
-    enqueue_websocket_event(WS_EVENT_CONNECT, (struct mg_connection*)conn, 0, NULL, 0);
-    return 0; 
+    hl_civetweb_server *server = (hl_civetweb_server*)user_data;
+    struct mg_connection *m_conn = (struct mg_connection*)conn;
+
+    int id = register_websocket(&server->ws_handles, m_conn);
+    if (id <= 0) {
+        mg_send_http_error(m_conn, 503, "%s", id < 0 ? "Too many pending WebSocket handshakes" : "Too many WebSocket connections");
+        return 1;
+    }
+
+    int length = 0;
+    char *handshake = format_handshake(mg_get_request_info(conn), &length);
+    if (!handshake) {
+        unregister_websocket(&server->ws_handles, id);
+        mg_send_http_error(m_conn, 500, "%s", "Out of memory");
+        return 1;
+    }
+    int posted = post_websocket_event(server, WS_EVENT_CONNECT, id, 0, handshake, length);
+    pool_free(handshake);
+    if (posted < 0) {
+        unregister_websocket(&server->ws_handles, id);
+        mg_send_http_error(m_conn, 503, "%s", "WebSocket events backlogged");
+        return 1;
+    }
+
+    int decision = await_websocket_decision(&server->ws_handles, id, server->websocket_accept_timeout_ms);
+    if (decision <= 0) {
+        unregister_websocket(&server->ws_handles, id);
+        // A late accept from Haxe fails on the stale id; the close event lets it drop any state
+        if (decision == 0) post_websocket_event(server, WS_EVENT_CLOSE, id, 0, NULL, 0);
+        mg_send_http_error(m_conn, 403, "%s", "WebSocket connection refused");
+        return 1;
+    }
+
+    mg_set_user_connection_data(conn, (void*)(intptr_t)id);
+    return 0;
 }
 
 // WebSocket callback: ready to communicate
 static void websocket_ready_handler(struct mg_connection *conn, void *user_data) {
-    enqueue_websocket_event(WS_EVENT_READY, conn, 0, NULL, 0);
+    hl_civetweb_server *server = (hl_civetweb_server*)user_data;
+    int id = websocket_id(conn);
+    if (id == 0) return;
+    mark_websocket_ready(&server->ws_handles, id);
+    if (post_websocket_event(server, WS_EVENT_READY, id, 0, NULL, 0) < 0) {
+        // Haxe would never learn the socket is open: ask the client to close it
+        mg_websocket_write(conn, MG_WEBSOCKET_OPCODE_CONNECTION_CLOSE, NULL, 0);
+    }
 }
 
 // WebSocket callback: data received
 static int websocket_data_handler(struct mg_connection *conn, int flags, char *data, size_t data_len, void *user_data) {
-    enqueue_websocket_event(WS_EVENT_DATA, conn, flags, data, (int)data_len);
-    return 1; // Keep connection open
+    hl_civetweb_server *server = (hl_civetweb_server*)user_data;
+    int id = websocket_id(conn);
+    if (id == 0) return 0; // Never accepted: close
+    // A message Haxe cannot be told about closes the connection rather than vanish from the stream
+    return post_websocket_event(server, WS_EVENT_DATA, id, flags, data, (int)data_len) == 0;
 }
 
 // WebSocket callback: connection closed
 static void websocket_close_handler(const struct mg_connection *conn, void *user_data) {
-    enqueue_websocket_event(WS_EVENT_CLOSE, (struct mg_connection*)conn, 0, NULL, 0);
+    hl_civetweb_server *server = (hl_civetweb_server*)user_data;
+    int id = websocket_id(conn);
+    if (id == 0) return;
+    // Invalidate before CivetWeb recycles the connection struct for another client
+    unregister_websocket(&server->ws_handles, id);
+    mg_set_user_connection_data(conn, NULL);
+    post_websocket_event(server, WS_EVENT_CLOSE, id, 0, NULL, 0);
 }
 
-// Helper: Wait for response with timeout (in milliseconds)
-static queued_response* wait_for_response(int request_id, int timeout_ms) {
-    int elapsed_ms = 0;
-    int sleep_interval_ms = 10; // Check every 10ms
-    
-    while (elapsed_ms < timeout_ms) {
-        lock_response_mutex();
-        
-        // Search for response
-        queued_response *prev = NULL;
-        queued_response *curr = g_response_queue_head;
-        
-        while (curr != NULL) {
-            if (curr->request_id == request_id) {
-                // Found it - remove from queue
-                if (prev) {
-                    prev->next = curr->next;
-                } else {
-                    g_response_queue_head = curr->next;
-                }
-                
-                if (curr == g_response_queue_tail) {
-                    g_response_queue_tail = prev;
-                }
-                
-                unlock_response_mutex();
-                return curr;
+// CivetWeb callback: any connection is closing. CivetWeb skips the WebSocket close handler
+// when the handshake fails after being accepted, so release such ids here.
+static void connection_close_handler(const struct mg_connection *conn) {
+    int id = websocket_id(conn);
+    if (id == 0) return;
+    hl_civetweb_server *server = (hl_civetweb_server*)mg_get_user_data(mg_get_context(conn));
+    unregister_websocket(&server->ws_handles, id);
+    post_websocket_event(server, WS_EVENT_CLOSE, id, 0, NULL, 0);
+}
+
+// Helper: Claim a response slot and assign the request its ID (must be called before it is enqueued).
+// Returns 0 when every slot is in use.
+static int acquire_response_slot(hl_civetweb_server *server, queued_request *req) {
+    mutex_lock(&server->response_mutex);
+    int index;
+    if (server->free_slot_head >= 0) {
+        index = server->free_slot_head;
+        server->free_slot_head = server->response_slots[index].next_free;
+    } else if (server->slots_used < RESPONSE_SLOT_COUNT) {
+        index = server->slots_used++;
+    } else {
+        mutex_unlock(&server->response_mutex);
+        return 0;
+    }
+
+    response_slot *slot = &server->response_slots[index];
+    slot->generation = (slot->generation + 1) & RESPONSE_GENERATION_MASK;
+    if (slot->generation == 0) slot->generation = 1; // Keep IDs positive and non-zero
+    slot->request = req;
+    req->request_id = (slot->generation << RESPONSE_SLOT_BITS) | index;
+    server->active_requests++;
+    mutex_unlock(&server->response_mutex);
+    return 1;
+}
+
+// Helper: Return a request's slot to the free list (response mutex must be held)
+static void release_response_slot(hl_civetweb_server *server, queued_request *req) {
+    int index = req->request_id & RESPONSE_SLOT_MASK;
+    response_slot *slot = &server->response_slots[index];
+    if (slot->request != req) return;
+    slot->request = NULL;
+    slot->next_free = server->free_slot_head;
+    server->free_slot_head = index;
+    server->active_requests--;
+    if (server->stopping) cond_broadcast(&server->drained);
+}
+
+// Helper: Requests stop() waits for before mg_stop (response mutex must be held): those holding a
+// slot, except parked long-polls and, without islands, requests the stopping main loop never polled,
+// plus answers still being written (their slot is already free)
+static int requests_to_drain(hl_civetweb_server *server) {
+    int unpolled = server->num_islands == 0 ? (int)atomic_load_acquire(&server->queue_depth) : 0;
+    return server->active_requests - server->suspended_count - unpolled + server->writing_responses;
+}
+
+// Helper: A worker has written the last byte of its answer (see writing_responses)
+static void finish_response_write(hl_civetweb_server *server) {
+    mutex_lock(&server->response_mutex);
+    server->writing_responses--;
+    if (server->stopping) cond_broadcast(&server->drained);
+    mutex_unlock(&server->response_mutex);
+}
+
+// Helper: Note that Haxe answered a request (response mutex must be held). Gaps are only sampled
+// while other requests were in flight, so idle time does not read as slow processing.
+static void record_completion(hl_civetweb_server *server) {
+    long long now = now_us();
+    if (server->last_completion_us > 0 && server->active_at_last_completion > 1) {
+        long long gap = now - server->last_completion_us;
+        long long interval = atomic_load_acquire(&server->completion_interval_us);
+        atomic_store_release(&server->completion_interval_us, interval > 0 ? (interval * 9 + gap) / 10 : gap);
+    }
+    server->last_completion_us = now;
+    server->active_at_last_completion = server->active_requests;
+}
+
+// Helper: Find the request still waiting on a given ID (response mutex must be held)
+static queued_request* find_waiting_request(hl_civetweb_server *server, int request_id) {
+    if (request_id <= 0) return NULL;
+    queued_request *req = server->response_slots[request_id & RESPONSE_SLOT_MASK].request;
+    return (req && req->request_id == request_id) ? req : NULL;
+}
+
+// Helper: Remove a request from its queue if Haxe has not polled it yet
+static void remove_queued_request(hl_civetweb_server *server, queued_request *req) {
+    request_queue *queue = req->queue;
+    mutex_lock(&queue->mutex);
+    queued_request *prev = NULL;
+    queued_request *curr = queue->head;
+    while (curr) {
+        if (curr == req) {
+            if (prev) {
+                prev->next = curr->next;
+            } else {
+                queue->head = curr->next;
             }
-            prev = curr;
-            curr = curr->next;
+            if (curr == queue->tail) {
+                queue->tail = prev;
+            }
+            queue->depth--;
+            atomic_add(&server->queue_depth, -1);
+            break;
         }
-        
-        unlock_response_mutex();
-        
-        // Sleep and retry
-#ifdef _WIN32
-        Sleep(sleep_interval_ms);
-#else
-        usleep(sleep_interval_ms * 1000);
-#endif
-        elapsed_ms += sleep_interval_ms;
+        prev = curr;
+        curr = curr->next;
     }
-    
-    return NULL; // Timeout
+    mutex_unlock(&queue->mutex);
+}
+
+// Helper: Block until push_response completes this request or its deadline passes.
+// The deadline is re-read on every wake-up, since suspend_request can move it.
+static queued_response* wait_for_response(hl_civetweb_server *server, queued_request *req) {
+    mutex_lock(&server->response_mutex);
+    while (!req->response) {
+        long long remaining = req->deadline_ms - now_ms();
+        if (remaining <= 0) break;
+        cond_wait(&req->done, &server->response_mutex, remaining);
+    }
+
+    if (req->suspended) {
+        req->suspended = 0;
+        server->suspended_count--;
+    }
+    queued_response *resp = req->response;
+    req->response = NULL;
+    if (resp) record_completion(server);
+    // The slot is freed before the write, so stop() counts the write separately; finished
+    // with finish_response_write. A streamed response keeps its slot until stream_response ends.
+    if (resp && !req->streaming) server->writing_responses++;
+    if (!req->streaming) release_response_slot(server, req);
+    mutex_unlock(&server->response_mutex);
+
+    if (!resp) {
+        // Timed out: make sure the poller can no longer see this request
+        remove_queued_request(server, req);
+    }
+    return resp;
 }
 
 // Helper: Check if a URI refers to a static file extension
@@ -267,12 +1388,691 @@ static int is_static_file(const char *uri) {
             return 1;
         }
     }
-    return 0;
+    return 0;
+}
+
+// Helper: Bytes needed for the "Name: value\n" header block, including the terminator
+static size_t request_headers_size(const struct mg_request_info *request_info) {
+    size_t size = 1;
+    for (int i = 0; i < request_info->num_headers; i++) {
+        size += strlen(request_info->http_headers[i].name) + strlen(request_info->http_headers[i].value) + 3;
+    }
+    return size;
+}
+
+// Helper: Copy a string into the request's trailing storage and advance the cursor
+static char* copy_request_string(char **cursor, const char *src) {
+    char *dst = *cursor;
+    size_t len = src ? strlen(src) : 0;
+    if (len > 0) memcpy(dst, src, len);
+    dst[len] = '\0';
+    *cursor += len + 1;
+    return dst;
+}
+
+// Helper: Write the "Name: value\n" header block at the cursor, NUL-terminated (cursor ends on the NUL)
+static void copy_request_headers(char **cursor, const struct mg_request_info *request_info) {
+    char *dst = *cursor;
+    for (int i = 0; i < request_info->num_headers; i++) {
+        const char *name = request_info->http_headers[i].name;
+        const char *value = request_info->http_headers[i].value;
+        size_t name_len = strlen(name);
+        size_t value_len = strlen(value);
+        memcpy(dst, name, name_len);
+        dst += name_len;
+        *dst++ = ':';
+        *dst++ = ' ';
+        memcpy(dst, value, value_len);
+        dst += value_len;
+        *dst++ = '\n';
+    }
+    *dst = '\0';
+    *cursor = dst;
+}
+
+// Helper: Allocate a request sized to the incoming request line and headers
+static queued_request* alloc_request(const struct mg_request_info *request_info) {
+    const char *uri = request_info->request_uri;
+    const char *method = request_info->request_method;
+    const char *query_string = request_info->query_string;
+    const char *remote_addr = request_info->remote_addr;
+
+    size_t strings_size = (uri ? strlen(uri) : 0) + 1
+                        + (method ? strlen(method) : 0) + 1
+                        + (query_string ? strlen(query_string) : 0) + 1
+                        + strlen(remote_addr) + 1
+                        + request_headers_size(request_info);
+
+    queued_request *req = (queued_request*)pool_alloc(sizeof(queued_request) + strings_size);
+    if (!req) return NULL;
+
+    memset(req, 0, sizeof(queued_request));
+    cond_init(&req->done);
+    cond_init(&req->drained);
+
+    char *cursor = (char*)(req + 1);
+    req->uri = copy_request_string(&cursor, uri);
+    req->method = copy_request_string(&cursor, method);
+    req->query_string = copy_request_string(&cursor, query_string);
+    req->remote_addr = copy_request_string(&cursor, remote_addr);
+
+    req->headers = cursor;
+    copy_request_headers(&cursor, request_info);
+
+    return req;
+}
+
+// Helper: Read the full request body into a buffer sized to it.
+// Returns 0 on success, -1 if the body exceeds max_body_size, -2 on allocation failure.
+static int read_request_body(struct mg_connection *conn, const struct mg_request_info *request_info, long long max_body_size, queued_request *req) {
+    long long content_length = request_info->content_length;
+    if (content_length == 0) return 0;
+    if (content_length > max_body_size) return -1;
+
+    // Unknown length (chunked transfer): grow the buffer as data arrives
+    size_t capacity = content_length > 0 ? (size_t)content_length + 1 : 4096;
+    char *body = (char*)pool_alloc(capacity);
+    if (!body) return -2;
+
+    size_t length = 0;
+    for (;;) {
+        if (length + 1 >= capacity) {
+            if (content_length > 0) break;
+            if ((long long)capacity > max_body_size) {
+                pool_free(body);
+                return -1;
+            }
+            char *grown = (char*)pool_alloc(capacity * 2);
+            if (!grown) {
+                pool_free(body);
+                return -2;
+            }
+            memcpy(grown, body, length);
+            pool_free(body);
+            body = grown;
+            capacity *= 2;
+        }
+        int n = mg_read(conn, body + length, capacity - length - 1);
+        if (n <= 0) break;
+        length += (size_t)n;
+    }
+
+    body[length] = '\0';
+    req->body = body;
+    req->body_length = (int)length;
+    return 0;
+}
+
+// Helper: Release a request and everything it owns
+static void free_request(queued_request *req) {
+    if (!req) return;
+    cond_destroy(&req->done);
+    cond_destroy(&req->drained);
+    if (req->body) pool_free(req->body);
+    pool_free(req);
+}
+
+// Helper: Check whether a "Name: value\n" header block contains a header (case-insensitive)
+static int has_header_line(const char *headers, const char *name) {
+    size_t name_len = strlen(name);
+    const char *line = headers;
+    while (line && *line) {
+        if (strncasecmp(line, name, name_len) == 0 && line[name_len] == ':') return 1;
+        line = strchr(line, '\n');
+        if (line) line++;
+    }
+    return 0;
+}
+
+#if defined(USE_ZLIB)
+// Helper: Value of a header in a "Name: value\n" block (runs to the end of its line), or NULL
+static const char* find_header_value(const char *headers, const char *name) {
+    size_t name_len = strlen(name);
+    const char *line = headers;
+    while (line && *line) {
+        if (strncasecmp(line, name, name_len) == 0 && line[name_len] == ':') {
+            const char *value = line + name_len + 1;
+            while (*value == ' ' || *value == '\t') value++;
+            return value;
+        }
+        line = strchr(line, '\n');
+        if (line) line++;
+    }
+    return NULL;
+}
+#endif
+
+// Helper: Add every line of a "Name: value\n" header block to the response.
+// The block is split in place. Framing headers are left to CivetWeb and send_response.
+static void add_header_lines(struct mg_connection *conn, char *headers) {
+    char *line = headers;
+    while (line && *line) {
+        char *next = strchr(line, '\n');
+        if (next) *next++ = '\0';
+
+        size_t len = strlen(line);
+        if (len > 0 && line[len - 1] == '\r') line[--len] = '\0';
+
+        char *colon = strchr(line, ':');
+        if (colon && colon != line) {
+            *colon = '\0';
+            char *value = colon + 1;
+            while (*value == ' ' || *value == '\t') value++;
+            if (_stricmp(line, "Content-Length") != 0
+                && _stricmp(line, "Transfer-Encoding") != 0
+                && _stricmp(line, "Connection") != 0) {
+                mg_response_header_add(conn, line, value, -1);
+            }
+        }
+        line = next;
+    }
+}
+
+// Helper: Send a complete response. CivetWeb fills in the reason phrase, Date and a
+// Connection header matching its own keep-alive decision for this connection.
+// headers (optional) is a "Name: value\n" block and is modified in place.
+// Helper: Whether the request being answered is a HEAD, whose response carries the headers a GET
+// would get but no body (writing one would desync the next response on a kept-alive connection)
+static int is_head_request(struct mg_connection *conn) {
+    const struct mg_request_info *request_info = mg_get_request_info(conn);
+    return request_info && request_info->request_method && strcmp(request_info->request_method, "HEAD") == 0;
+}
+
+static void send_response(struct mg_connection *conn, int status_code, const char *content_type, char *headers, const char *body, int body_length) {
+    // 1xx, 204 and 304 responses never carry a body
+    int bodyless = status_code < 200 || status_code == 204 || status_code == 304;
+    char length_str[32];
+    snprintf(length_str, sizeof(length_str), "%d", body_length);
+
+    mg_response_header_start(conn, status_code);
+    if (headers && *headers) {
+        if (!has_header_line(headers, "Content-Type")) {
+            mg_response_header_add(conn, "Content-Type", content_type, -1);
+        }
+        add_header_lines(conn, headers);
+    } else {
+        mg_response_header_add(conn, "Content-Type", content_type, -1);
+    }
+    if (!bodyless) {
+        mg_response_header_add(conn, "Content-Length", length_str, -1);
+    }
+    mg_response_header_send(conn);
+
+    if (!bodyless && body_length > 0 && !is_head_request(conn)) {
+        mg_write(conn, body, body_length);
+    }
+}
+
+// Helper: Send the head of a streamed response; the body follows with chunked framing
+static void send_stream_head(struct mg_connection *conn, queued_response *resp) {
+    mg_response_header_start(conn, resp->status_code);
+    if (!has_header_line(resp->headers, "Content-Type")) {
+        mg_response_header_add(conn, "Content-Type", resp->content_type, -1);
+    }
+    add_header_lines(conn, resp->headers);
+    mg_response_header_add(conn, "Transfer-Encoding", "chunked", -1);
+    mg_response_header_send(conn);
+}
+
+// Helper: Relay a streamed response: write chunks as push_chunk queues them until
+// end_response is called, the client goes away, or no chunk arrives for idle_timeout_ms.
+// For HEAD the chunks are consumed but not written. Returns 0 if the stream was ended by Haxe,
+// -1 if it was cut short.
+static int stream_response(struct mg_connection *conn, hl_civetweb_server *server, queued_request *req, queued_response *resp, int idle_timeout_ms) {
+    send_stream_head(conn, resp);
+
+    int head = is_head_request(conn);
+    int ended = 0;
+    int failed = 0;
+    mutex_lock(&server->response_mutex);
+    for (;;) {
+        long long deadline = now_ms() + idle_timeout_ms;
+        while (!req->chunks_head && !req->stream_ended) {
+            long long remaining = deadline - now_ms();
+            if (remaining <= 0) break;
+            cond_wait(&req->done, &server->response_mutex, remaining);
+        }
+        if (!req->chunks_head && !req->stream_ended) break;
+
+        // Write outside the lock so producers can keep queueing
+        response_chunk *chunk = req->chunks_head;
+        req->chunks_head = req->chunks_tail = NULL;
+        ended = req->stream_ended;
+        mutex_unlock(&server->response_mutex);
+
+        size_t written = 0;
+        while (chunk) {
+            response_chunk *next = chunk->next;
+            if (!failed && !head && mg_send_chunk(conn, (const char*)(chunk + 1), (unsigned int)chunk->length) < 0) {
+                failed = 1;
+            }
+            written += (size_t)chunk->length;
+            pool_free(chunk);
+            chunk = next;
+        }
+
+        mutex_lock(&server->response_mutex);
+        req->chunk_bytes -= written;
+        cond_broadcast(&req->drained);
+        if (failed || ended) break;
+    }
+
+    // Close the stream: the ID stops resolving, blocked producers give up,
+    // and the request is only freed once none of them still reference it
+    req->stream_closed = 1;
+    server->writing_responses++;
+    release_response_slot(server, req);
+    while (req->chunks_head) {
+        response_chunk *next = req->chunks_head->next;
+        pool_free(req->chunks_head);
+        req->chunks_head = next;
+    }
+    req->chunks_tail = NULL;
+    cond_broadcast(&req->drained);
+    while (req->stream_waiters > 0) {
+        cond_wait(&req->done, &server->response_mutex, 1000);
+    }
+    mutex_unlock(&server->response_mutex);
+
+    // Terminating chunk. After a timeout this ends a truncated body, which keeps the framing intact.
+    if (!failed && !head) mg_send_chunk(conn, "", 0);
+    finish_response_write(server);
+    return (ended && !failed) ? 0 : -1;
+}
+
+// Helper: Send a plain text response generated by the bridge itself
+static void send_text_response(struct mg_connection *conn, int status_code, const char *text) {
+    char headers[] = "Access-Control-Allow-Origin: *\n";
+    send_response(conn, status_code, "text/plain", headers, text, (int)strlen(text));
+}
+
+// Helper: Shed a request without involving Haxe; the client is told to come back shortly
+static void send_retry_later(struct mg_connection *conn, const char *text) {
+    char headers[] = "Access-Control-Allow-Origin: *\nRetry-After: 1\n";
+    send_response(conn, 503, "text/plain", headers, text, (int)strlen(text));
+}
+
+// Helper: Whether an Accept-Encoding value allows a content coding. q=0 refuses it,
+// "*" covers codings the client did not list explicitly.
+static int accepts_encoding(const char *header, const char *coding) {
+    size_t coding_len = strlen(coding);
+    int wildcard = 0;
+    const char *p = header;
+    while (*p) {
+        while (*p == ' ' || *p == '\t' || *p == ',') p++;
+        if (!*p) break;
+        size_t name_len = strcspn(p, ",;");
+        const char *end = p + strcspn(p, ",");
+        double q = 1.0;
+        for (const char *param = p + name_len; param + 1 < end; param++) {
+            if ((param[0] == 'q' || param[0] == 'Q') && param[1] == '=') {
+                q = atof(param + 2);
+                break;
+            }
+        }
+        while (name_len > 0 && (p[name_len - 1] == ' ' || p[name_len - 1] == '\t')) name_len--;
+        if (name_len == coding_len && strncasecmp(p, coding, coding_len) == 0) return q > 0;
+        if (name_len == 1 && *p == '*') wildcard = q > 0;
+        p = end;
+    }
+    return wildcard;
+}
+
+#if defined(USE_ZLIB)
+// Helper: Whether a Content-Type starts with one of the server's compressible type prefixes
+static int is_compressible_type(hl_civetweb_server *server, const char *content_type) {
+    if (!content_type) return 0;
+    const char **types = server->num_compress_types > 0 ? (const char**)server->compress_types : DEFAULT_COMPRESS_TYPES;
+    int count = server->num_compress_types > 0 ? server->num_compress_types : NUM_DEFAULT_COMPRESS_TYPES;
+    for (int i = 0; i < count; i++) {
+        if (strncasecmp(content_type, types[i], strlen(types[i])) == 0) return 1;
+    }
+    return 0;
+}
+
+// Helper: Gzip a body in one pass. Returns a buffer to release with pool_free, or NULL if zlib
+// fails or the result would not be smaller than the original.
+static char* gzip_body(const char *body, int body_length, int level, int *gzip_length) {
+    z_stream zs;
+    memset(&zs, 0, sizeof(zs));
+    // windowBits 15 + 16 selects the gzip wrapper instead of raw zlib
+    if (deflateInit2(&zs, level, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) return NULL;
+
+    uLong bound = deflateBound(&zs, (uLong)body_length);
+    char *out = (char*)pool_alloc(bound);
+    int ok = 0;
+    if (out) {
+        zs.next_in = (Bytef*)body;
+        zs.avail_in = (uInt)body_length;
+        zs.next_out = (Bytef*)out;
+        zs.avail_out = (uInt)bound;
+        ok = deflate(&zs, Z_FINISH) == Z_STREAM_END && zs.total_out < (uLong)body_length;
+    }
+    *gzip_length = (int)zs.total_out;
+    deflateEnd(&zs);
+    if (!ok) {
+        if (out) pool_free(out);
+        return NULL;
+    }
+    return out;
+}
+#endif
+
+// Helper: Send a buffered Haxe response, gzipped when the body reaches compress_min_size,
+// its type is compressible, Haxe did not encode it already and the client accepts gzip.
+// Compressible responses carry Vary: Accept-Encoding either way so caches keep them apart.
+static void send_dynamic_response(struct mg_connection *conn, hl_civetweb_server *server, int status_code, const char *content_type, char *headers, const char *body, int body_length) {
+#if defined(USE_ZLIB)
+    int bodyless = status_code < 200 || status_code == 204 || status_code == 304;
+    const char *type = headers ? find_header_value(headers, "Content-Type") : NULL;
+    if (!type) type = content_type;
+    if (!bodyless && server->compress_min_size >= 0 && body_length >= server->compress_min_size
+        && is_compressible_type(server, type)
+        && !(headers && has_header_line(headers, "Content-Encoding"))) {
+        const char *accept = mg_get_header(conn, "Accept-Encoding");
+        int gzip_length = 0;
+        char *gzipped = (accept && accepts_encoding(accept, "gzip"))
+            ? gzip_body(body, body_length, server->compress_level, &gzip_length) : NULL;
+
+        size_t headers_len = headers ? strlen(headers) : 0;
+        char *extended = (char*)pool_alloc(headers_len + 64);
+        if (extended) {
+            if (headers_len > 0) memcpy(extended, headers, headers_len);
+            snprintf(extended + headers_len, 64, "%s%sVary: Accept-Encoding\n",
+                (headers_len > 0 && headers[headers_len - 1] != '\n') ? "\n" : "",
+                gzipped ? "Content-Encoding: gzip\n" : "");
+            send_response(conn, status_code, content_type, extended,
+                gzipped ? gzipped : body, gzipped ? gzip_length : body_length);
+            pool_free(extended);
+            if (gzipped) pool_free(gzipped);
+            return;
+        }
+        if (gzipped) pool_free(gzipped);
+    }
+#else
+    (void)server;
+#endif
+    send_response(conn, status_code, content_type, headers, body, body_length);
+}
+
+// Helper: Longest static mount whose prefix covers a path segment-wise, or NULL
+static static_mount* find_static_mount(hl_civetweb_server *server, const char *path) {
+    static_mount *best = NULL;
+    for (int i = 0; i < server->num_static_mounts; i++) {
+        static_mount *mount = &server->static_mounts[i];
+        if (best && mount->prefix_len <= best->prefix_len) continue;
+        if (mount->prefix_len == 1) {
+            best = mount;
+        } else if (strncmp(path, mount->prefix, mount->prefix_len) == 0
+            && (path[mount->prefix_len] == '\0' || path[mount->prefix_len] == '/')) {
+            best = mount;
+        }
+    }
+    return best;
+}
+
+// Helper: Map a request path into a mount's directory. Returns 0 for paths that could escape it.
+static int resolve_static_path(static_mount *mount, const char *path, char *out, size_t out_size) {
+    const char *rest = path + (mount->prefix_len == 1 ? 0 : mount->prefix_len);
+    for (const char *seg = rest; *seg; ) {
+        if (*seg == '\\' || *seg == ':') return 0;
+        if (*seg == '/') {
+            seg++;
+            continue;
+        }
+        size_t seg_len = strcspn(seg, "/");
+        if (seg_len == 2 && seg[0] == '.' && seg[1] == '.') return 0;
+        seg += seg_len;
+    }
+    int written = snprintf(out, out_size, "%s%s", mount->directory, rest);
+    return written > 0 && (size_t)written < out_size;
+}
+
+// Helper: Format a time as an HTTP-date ("Sun, 06 Nov 1994 08:49:37 GMT")
+static void format_http_date(time_t t, char *out, size_t out_size) {
+    struct tm tm;
+#ifdef _WIN32
+    gmtime_s(&tm, &t);
+#else
+    gmtime_r(&t, &tm);
+#endif
+    static const char *days[] = { "Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat" };
+    static const char *months[] = { "Jan", "Feb", "Mar", "Apr", "May", "Jun", "Jul", "Aug", "Sep", "Oct", "Nov", "Dec" };
+    snprintf(out, out_size, "%s, %02d %s %04d %02d:%02d:%02d GMT",
+        days[tm.tm_wday], tm.tm_mday, months[tm.tm_mon], tm.tm_year + 1900, tm.tm_hour, tm.tm_min, tm.tm_sec);
+}
+
+// Helper: Parse an IMF-fixdate HTTP-date into seconds since the epoch, -1 if malformed
+static long long parse_http_date(const char *text) {
+    static const char months[] = "JanFebMarAprMayJunJulAugSepOctNovDec";
+    char month[4];
+    int day, year, hour, minute, second;
+    if (sscanf(text, "%*3s, %d %3s %d %d:%d:%d", &day, month, &year, &hour, &minute, &second) != 6) return -1;
+    const char *found = strstr(months, month);
+    if (!found || strlen(month) != 3 || (found - months) % 3 != 0) return -1;
+    int m = (int)(found - months) / 3 + 1;
+
+    // Days from civil (proleptic Gregorian), independent of the local time zone
+    int y = year - (m <= 2);
+    long long era = (y >= 0 ? y : y - 399) / 400;
+    long long yoe = y - era * 400;
+    long long doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    long long doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    long long days = era * 146097 + doe - 719468;
+    return days * 86400 + hour * 3600 + minute * 60 + second;
+}
+
+// Helper: Whether an If-None-Match list names this ETag (weak comparison, as RFC 9110 requires)
+static int etag_matches(const char *header, const char *etag) {
+    size_t etag_len = strlen(etag);
+    const char *p = header;
+    while (*p) {
+        while (*p == ' ' || *p == '\t' || *p == ',') p++;
+        if (*p == '*') return 1;
+        if (p[0] == 'W' && p[1] == '/') p += 2;
+        size_t len = strcspn(p, ",");
+        while (len > 0 && (p[len - 1] == ' ' || p[len - 1] == '\t')) len--;
+        if (len == etag_len && strncmp(p, etag, len) == 0) return 1;
+        p += strcspn(p, ",");
+    }
+    return 0;
+}
+
+// Precompressed siblings a static file may have, in order of preference
+static const struct {
+    const char *suffix;
+    const char *coding;
+} STATIC_ENCODINGS[] = {
+    { ".br", "br" },
+    { ".gz", "gzip" }
+};
+#define NUM_STATIC_ENCODINGS (int)(sizeof(STATIC_ENCODINGS) / sizeof(STATIC_ENCODINGS[0]))
+
+// Helper: Answer a request under a static mount entirely in native code. Validators come
+// first so revalidations cost a few stats (the file and its .br/.gz siblings); the body goes
+// out through mg_send_file_body, which uses sendfile on Linux. Returns the status code sent,
+// or 0 without sending anything for methods other than GET/HEAD and paths with no file behind
+// them, so a mount (even one at "/") never hides dynamic routes.
+static int serve_static(struct mg_connection *conn, const struct mg_request_info *request_info, static_mount *mount) {
+    int head = is_head_request(conn);
+    if (!head && strcmp(request_info->request_method, "GET") != 0) return 0;
+
+    char path[4096];
+    struct stat st;
+    if (!resolve_static_path(mount, request_info->local_uri, path, sizeof(path) - 11)) {
+        send_text_response(conn, 404, "Not found");
+        return 404;
+    }
+    if (stat(path, &st) == 0 && S_ISDIR(st.st_mode)) {
+        size_t len = strlen(path);
+        snprintf(path + len, sizeof(path) - len, "%sindex.html", (len > 0 && path[len - 1] == '/') ? "" : "/");
+    }
+    if (stat(path, &st) != 0 || !S_ISREG(st.st_mode)) return 0;
+
+    // Serve the first precompressed sibling the client accepts. The representation differs,
+    // so it gets its own ETag; Vary is sent whenever a sibling exists, accepted or not.
+    const char *accept = mg_get_header(conn, "Accept-Encoding");
+    const char *file = path;
+    const char *coding = NULL;
+    int has_variants = 0;
+    char variant[sizeof(path) + 4];
+    for (int i = 0; i < NUM_STATIC_ENCODINGS; i++) {
+        char candidate[sizeof(variant)];
+        struct stat variant_st;
+        snprintf(candidate, sizeof(candidate), "%s%s", path, STATIC_ENCODINGS[i].suffix);
+        if (stat(candidate, &variant_st) != 0 || !S_ISREG(variant_st.st_mode)) continue;
+        has_variants = 1;
+        if (!coding && accept && accepts_encoding(accept, STATIC_ENCODINGS[i].coding)) {
+            memcpy(variant, candidate, sizeof(variant));
+            file = variant;
+            coding = STATIC_ENCODINGS[i].coding;
+            st = variant_st;
+        }
+    }
+
+    // mtime-size does not prove two bodies are byte-identical, so the ETag is weak
+    char etag[64];
+    char last_modified[64];
+    snprintf(etag, sizeof(etag), "W/\"%llx-%llx%s%s\"", (unsigned long long)st.st_mtime, (unsigned long long)st.st_size,
+        coding ? "-" : "", coding ? coding : "");
+    format_http_date(st.st_mtime, last_modified, sizeof(last_modified));
+
+    // If-None-Match takes precedence; If-Modified-Since is only consulted without it
+    const char *if_none_match = mg_get_header(conn, "If-None-Match");
+    const char *if_modified_since = mg_get_header(conn, "If-Modified-Since");
+    int not_modified = if_none_match
+        ? etag_matches(if_none_match, etag + 2)
+        : (if_modified_since && (long long)st.st_mtime <= parse_http_date(if_modified_since));
+
+    int status_code = not_modified ? 304 : 200;
+    mg_response_header_start(conn, status_code);
+    mg_response_header_add(conn, "ETag", etag, -1);
+    mg_response_header_add(conn, "Last-Modified", last_modified, -1);
+    if (mount->cache_control) mg_response_header_add(conn, "Cache-Control", mount->cache_control, -1);
+    if (has_variants) mg_response_header_add(conn, "Vary", "Accept-Encoding", -1);
+    if (!not_modified) {
+        char length_str[32];
+        snprintf(length_str, sizeof(length_str), "%lld", (long long)st.st_size);
+        // Content-Type describes the original file, whichever encoding goes out
+        mg_response_header_add(conn, "Content-Type", mg_get_builtin_mime_type(path), -1);
+        if (coding) mg_response_header_add(conn, "Content-Encoding", coding, -1);
+        mg_response_header_add(conn, "Content-Length", length_str, -1);
+    }
+    mg_response_header_send(conn);
+
+    if (!not_modified && !head && st.st_size > 0) mg_send_file_body(conn, file);
+    return status_code;
+}
+
+// Helper: Match a Router pattern against a request path. ":name" matches one
+// non-empty segment, ":*name" matches the (non-empty) rest of the path.
+static int match_route_pattern(const char *pattern, const char *path) {
+    while (*pattern) {
+        if (*pattern == ':') {
+            if (*path == '\0' || *path == '/') return 0;
+            if (pattern[1] == '*') return 1;
+            while (*path && *path != '/') path++;
+            while (*pattern && *pattern != '/') pattern++;
+            continue;
+        }
+        if (*pattern != *path) return 0;
+        pattern++;
+        path++;
+    }
+    return *path == '\0';
+}
+
+// Helper: Timeout for a request: the first matching route timeout, else the server default
+static int request_timeout_ms(hl_civetweb_server *server, const struct mg_request_info *request_info) {
+    // Same path the adapter routes on: the request URI without its query string
+    const char *path = request_info->request_uri;
+    if (!path || !request_info->request_method) return server->default_timeout_ms;
+    for (int i = 0; i < server->num_route_timeouts; i++) {
+        route_timeout *rt = &server->route_timeouts[i];
+        if (strcmp(rt->method, request_info->request_method) == 0
+            && match_route_pattern(rt->pattern, path)) {
+            return rt->timeout_ms > 0 ? rt->timeout_ms : server->default_timeout_ms;
+        }
+    }
+    return server->default_timeout_ms;
+}
+
+// Helper: Count a request shed before it reached Haxe
+static void count_rejected(hl_civetweb_server *server) {
+    atomic_add(&server->rejected_count, 1);
+}
+
+// Helper: Admission check. Returns 0 if the requests already queued ahead of this one
+// cannot be drained at the observed completion rate before its timeout expires.
+// Lock-free: the estimate is a single atomic published by record_completion.
+static int can_meet_deadline(hl_civetweb_server *server, int depth, int timeout_ms) {
+    if (depth == 0) return 1;
+
+    long long interval_us = atomic_load_acquire(&server->completion_interval_us);
+    return (double)depth * (double)interval_us < (double)timeout_ms * 1000.0;
+}
+
+// Helper: Set up an empty request queue
+static void init_request_queue(request_queue *queue) {
+    memset(queue, 0, sizeof(*queue));
+    mutex_init(&queue->mutex);
+    cond_init(&queue->ready);
+}
+
+// Helper: Release a request queue's lock and condition (the queue must be empty)
+static void destroy_request_queue(request_queue *queue) {
+    mutex_destroy(&queue->mutex);
+    cond_destroy(&queue->ready);
+}
+
+// Helper: Pick the queue a request goes on. Without islands that is the shared queue; with
+// them, the session_id cookie is hashed (FNV-1a) so a session always lands on the same island,
+// and requests without one are spread round-robin.
+static request_queue* select_queue(hl_civetweb_server *server, struct mg_connection *conn) {
+    if (server->num_islands == 0) return &server->pending;
+
+    char session_id[128];
+    const char *cookies = mg_get_header(conn, "Cookie");
+    if (cookies && mg_get_cookie(cookies, "session_id", session_id, sizeof(session_id)) > 0) {
+        unsigned int hash = 2166136261u;
+        for (const char *p = session_id; *p; p++) {
+            hash = (hash ^ (unsigned char)*p) * 16777619u;
+        }
+        return &server->island_queues[hash % (unsigned int)server->num_islands];
+    }
+
+    long long turn;
+    do {
+        turn = atomic_load_acquire(&server->next_island);
+    } while (!atomic_cas(&server->next_island, turn, turn + 1));
+    return &server->island_queues[turn % server->num_islands];
+}
+
+// Helper: Append a request to its queue and wake the island waiting on it
+static void enqueue_request(hl_civetweb_server *server, queued_request *req) {
+    request_queue *queue = req->queue;
+    mutex_lock(&queue->mutex);
+    req->next = NULL;
+    req->enqueued_ms = now_ms();
+    req->enqueued_us = now_us();
+    if (queue->tail) {
+        queue->tail->next = req;
+    } else {
+        queue->head = req;
+    }
+    queue->tail = req;
+    queue->depth++;
+    atomic_add(&server->queue_depth, 1);
+    cond_signal(&queue->ready);
+    mutex_unlock(&queue->mutex);
+    if (queue == &server->pending) signal_work(server);
 }
 
 // Request handler callback that queues requests for Haxe polling
 static int request_handler(struct mg_connection *conn) {
+    long long accepted_us = now_us();
     const struct mg_request_info *request_info = mg_get_request_info(conn);
+    hl_civetweb_server *server = (hl_civetweb_server*)mg_get_user_data(mg_get_context(conn));
     
     // Check for WebSocket upgrade - let CivetWeb handle it
     const char *upgrade = mg_get_header(conn, "Upgrade");
@@ -280,131 +2080,137 @@ static int request_handler(struct mg_connection *conn) {
         return 0;
     }
     
+    // Static mounts are answered here without involving Haxe; what they have no file for falls through
+    static_mount *mount = server->num_static_mounts > 0 ? find_static_mount(server, request_info->local_uri) : NULL;
+    if (mount) {
+        int served = serve_static(conn, request_info, mount);
+        if (served) return served;
+    }
+    
     // Check for static files - let CivetWeb handle them natively
     if (is_static_file(request_info->request_uri)) {
         return 0;
     }
     
-    // Allocate and populate request
-    queued_request *req = (queued_request*)malloc(sizeof(queued_request));
-    if (!req) {
-        mg_printf(conn, "HTTP/1.1 500 Internal Server Error\r\n"
-                       "Content-Type: text/plain\r\n"
-                       "Content-Length: 21\r\n\r\n"
-                       "Memory allocation error");
-        return 1;
+    // stop() is letting the requests already in flight finish; take no new ones
+    if (server->stopping) {
+        send_retry_later(conn, "Server is shutting down");
+        return 503;
     }
     
-    memset(req, 0, sizeof(queued_request));
-    
-    // Assign request ID
-    lock_request_mutex();
-    req->request_id = g_next_request_id++;
-    unlock_request_mutex();
-    
-    int local_request_id = req->request_id;
-    printf("[CivetWebNative] Handled request %d: %s %s\n", local_request_id, request_info->request_method, request_info->request_uri);
-    fflush(stdout);
-
-    
-    req->conn = conn;
-    
-    // Copy request data (with bounds checking)
-    if (request_info->request_uri) {
-        strncpy(req->uri, request_info->request_uri, sizeof(req->uri) - 1);
-    }
-    if (request_info->request_method) {
-        strncpy(req->method, request_info->request_method, sizeof(req->method) - 1);
+    // Shed load before touching the body or the VM: over the high-water mark, or when
+    // the queue ahead cannot drain before this request would time out anyway
+    int depth = (int)atomic_load_acquire(&server->queue_depth);
+    if (server->max_queue_depth > 0 && depth >= server->max_queue_depth) {
+        count_rejected(server);
+        send_retry_later(conn, "Server is too busy");
+        return 503;
     }
-    if (request_info->query_string) {
-        strncpy(req->query_string, request_info->query_string, sizeof(req->query_string) - 1);
-    }
-    if (request_info->remote_addr) {
-        strncpy(req->remote_addr, request_info->remote_addr, sizeof(req->remote_addr) - 1);
+    int timeout_ms = request_timeout_ms(server, request_info);
+    if (!can_meet_deadline(server, depth, timeout_ms)) {
+        count_rejected(server);
+        send_retry_later(conn, "Server is too busy to answer in time");
+        return 503;
     }
     
-    // Collect headers
-    int headers_offset = 0;
-    for (int i = 0; i < request_info->num_headers; i++) {
-        int remain = sizeof(req->headers) - headers_offset - 1;
-        if (remain <= 0) break;
-        
-        int written = snprintf(req->headers + headers_offset, 
-                              remain,
-                              "%s: %s\n",
-                              request_info->http_headers[i].name,
-                              request_info->http_headers[i].value);
-        
-        if (written > 0) {
-            headers_offset += (written < remain) ? written : remain;
-        }
+    // Allocate and populate request
+    queued_request *req = alloc_request(request_info);
+    if (!req) {
+        send_text_response(conn, 500, "Memory allocation error");
+        return 500;
     }
-    req->headers[headers_offset] = '\0';
+    req->conn = conn;
+    req->timeout_ms = timeout_ms;
+    req->accepted_us = accepted_us;
     
     // Read request body if present
-    const char *cl_str = mg_get_header(conn, "Content-Length");
-    int cl = cl_str ? atoi(cl_str) : 0;
-    
-    if (cl > 0) {
-        int to_read = cl < (sizeof(req->body) - 1) ? cl : (sizeof(req->body) - 1);
-        int body_len = mg_read(conn, req->body, to_read);
-        if (body_len > 0) {
-            req->body[body_len] = '\0';
-            req->body_length = body_len;
-        } else {
-            req->body[0] = '\0';
-            req->body_length = 0;
+    int body_status = read_request_body(conn, request_info, server->max_body_size, req);
+    if (body_status != 0) {
+        free_request(req);
+        // The unread body prevents CivetWeb from reusing this connection
+        if (body_status == -1) {
+            send_text_response(conn, 413, "Request body is too large");
+            return 413;
         }
-    } else {
-        req->body[0] = '\0';
-        req->body_length = 0;
+        send_text_response(conn, 500, "Memory allocation error");
+        return 500;
     }
     
-    // Save ID locally before enqueuing (in case req is corrupted later)
-    printf("[CivetWebNative] Request %d body length: %d\n", local_request_id, req->body_length);
-    fflush(stdout);
+    // Assign request ID and make the completion slot visible to push_response
+    // before Haxe can see the request
+    if (!acquire_response_slot(server, req)) {
+        free_request(req);
+        count_rejected(server);
+        send_retry_later(conn, "Server is too busy");
+        return 503;
+    }
     
-    // Enqueue request
-    lock_request_mutex();
-    req->next = NULL;
-    if (g_request_queue_tail) {
-        g_request_queue_tail->next = req;
-    } else {
-        g_request_queue_head = req;
+    int local_request_id = req->request_id;
+    req->deadline_ms = now_ms() + timeout_ms;
+    if (trace_enabled(TRACE_DEBUG)) {
+        char line[TRACE_TEXT_SIZE];
+        snprintf(line, sizeof(line), "%s %s", req->method, req->uri);
+        trace_write(TRACE_DEBUG, TRACE_REQUEST_HANDLED, local_request_id, req->body_length, line);
     }
-    g_request_queue_tail = req;
-    unlock_request_mutex();
     
-    // Wait for response (30 second timeout)
-    queued_response *resp = wait_for_response(local_request_id, 30000);
+    // Enqueue request
+    req->queue = select_queue(server, conn);
+    enqueue_request(server, req);
+    
+    // Wait for response (until the route timeout unless the request is suspended)
+    queued_response *resp = wait_for_response(server, req);
+    if (resp) record_latency(server->latency, STAGE_RESPONSE_WAIT, now_us() - req->responded_us);
     
-    if (resp) {
-        // Send response
-
-        mg_printf(conn, "HTTP/1.1 %d OK\r\n", resp->status_code);
-        mg_printf(conn, "Content-Type: %s\r\n", resp->content_type);
-        mg_printf(conn, "Content-Length: %d\r\n", resp->body_length);
-        mg_printf(conn, "Access-Control-Allow-Origin: *\r\n");
-        mg_printf(conn, "Connection: close\r\n\r\n");
-        
-        if (resp->body_length > 0) {
-            mg_write(conn, resp->body, resp->body_length);
+    if (resp && req->streaming) {
+        int status_code = resp->status_code;
+        if (stream_response(conn, server, req, resp, req->timeout_ms) != 0) {
+            trace(TRACE_WARN, TRACE_STREAM_CUT_SHORT, local_request_id, 0, NULL);
         }
         
-        free(resp);
+        pool_free(resp);
+        
+        free_request(req);
+        return status_code;
+    }
+    
+    if (resp) {
+        // Send response (Content-Length framing lets CivetWeb keep the connection alive)
+        int status_code = resp->status_code;
+        long long write_us = now_us();
+        send_dynamic_response(conn, server, status_code, resp->content_type, resp->headers, resp->body, resp->body_length);
+        finish_response_write(server);
+        long long written_us = now_us();
+        record_latency(server->latency, STAGE_WRITE, written_us - write_us);
+        record_latency(server->latency, STAGE_TOTAL, written_us - req->accepted_us);
+        
+        pool_free(resp);
 
-        free(req);
-        return 1;
+        free_request(req);
+        return status_code;
+    }
+    
+    // Cut short by stop() rather than timed out
+    if (server->stopping) {
+        send_retry_later(conn, "Server is shutting down");
+        free_request(req);
+        return 503;
     }
     
     // Timeout - send 504
-    mg_printf(conn, "HTTP/1.1 504 Gateway Timeout\r\n"
-                   "Content-Type: text/plain\r\n"
-                   "Content-Length: 37\r\n\r\n"
-                   "Request processing timeout (30 seconds)");
+    send_text_response(conn, 504, "Request processing timeout");
     
-    free(req);
-    return 1;
+    free_request(req);
+    return 504;
+}
+
+// Helper: Look up an option set through set_option
+static const char* find_option(hl_civetweb_server *server, const char *name) {
+    for (int i = 0; i < server->num_options; i++) {
+        if (strcmp(server->options[2 * i], name) == 0) {
+            return server->options[2 * i + 1];
+        }
+    }
+    return NULL;
 }
 
 // Create a new CivetWeb server instance
@@ -420,12 +2226,32 @@ HL_PRIM hl_civetweb_server* HL_NAME(create)(vbyte *host, int port, vbyte *docume
         server->document_root = strdup((char*)document_root);
     }
     
-    // Initialize mutexes immediately
-    init_mutexes();
-    
-    printf("[CivetWebNative] Creating server handle (Build: %s %s)\n", __DATE__, __TIME__);
-    fflush(stdout);
+    // Queues, slots and WebSocket ids start empty for every server
+    init_process_mutexes();
+    init_request_queue(&server->pending);
+    mutex_init(&server->work_mutex);
+    cond_init(&server->work_ready);
+    server->wakeup_fds[0] = server->wakeup_fds[1] = -1;
+    mutex_init(&server->response_mutex);
+    cond_init(&server->drained);
+    mutex_init(&server->ws_handles.mutex);
+    cond_init(&server->ws_handles.decided);
+    cond_init(&server->ws_handles.unpinned);
+    server->ws_handles.next_id = 1;
+    server->ws_handles.max_pending = DEFAULT_MAX_PENDING_HANDSHAKES;
+    server->free_slot_head = -1;
+    init_websocket_ring(&server->ws_events);
+    
+    trace(TRACE_INFO, TRACE_SERVER_CREATED, 0, 0, __DATE__ " " __TIME__);
     server->running = 0;
+    server->stopping = 0;
+    server->max_body_size = DEFAULT_MAX_BODY_SIZE;
+    server->max_suspended = DEFAULT_MAX_SUSPENDED;
+    server->default_timeout_ms = DEFAULT_TIMEOUT_MS;
+    server->max_queue_depth = DEFAULT_MAX_QUEUE_DEPTH;
+    server->websocket_accept_timeout_ms = DEFAULT_WEBSOCKET_ACCEPT_TIMEOUT_MS;
+    server->compress_min_size = DEFAULT_COMPRESS_MIN_SIZE;
+    server->compress_level = DEFAULT_COMPRESS_LEVEL;
     return server;
 }
 
@@ -433,40 +2259,73 @@ HL_PRIM hl_civetweb_server* HL_NAME(create)(vbyte *host, int port, vbyte *docume
 HL_PRIM bool HL_NAME(start)(hl_civetweb_server *server) {
     if (!server || server->running) return false;
     
-    // Initialize mutexes for queue system
-    init_mutexes();
-    
     // Setup callbacks
     memset(&server->callbacks, 0, sizeof(server->callbacks));
     server->callbacks.begin_request = request_handler;
+    server->callbacks.connection_close = connection_close_handler;
+    server->callbacks.exit_thread = exit_thread_handler;
     
-    // Build options array
+    // Build options array: listener and document root from create, defaults the
+    // caller did not override, then every option set through set_option
     char port_str[32];
     snprintf(port_str, sizeof(port_str), "%d", server->port);
     
-    const char *options[10];
+    const char **options = (const char**)malloc(sizeof(const char*) * (size_t)(2 * server->num_options + 11));
+    if (!options) return false;
     int opt_index = 0;
     
-    options[opt_index++] = "listening_ports";
-    options[opt_index++] = port_str;
+    if (!find_option(server, "listening_ports")) {
+        options[opt_index++] = "listening_ports";
+        options[opt_index++] = port_str;
+    }
     
-    if (server->document_root) {
+    if (server->document_root && !find_option(server, "document_root")) {
         options[opt_index++] = "document_root";
         options[opt_index++] = server->document_root;
     }
     
+    // Suspended requests park on workers of their own on top of num_threads, so long-polls
+    // never starve regular traffic. CivetWeb only spawns workers when none is idle, so unused
+    // parking capacity costs no threads, but every parked long-poll is a thread. The adapter
+    // logs the raised count (get_worker_threads).
+    const char *num_threads = find_option(server, "num_threads");
+    snprintf(server->num_threads, sizeof(server->num_threads), "%d",
+             atoi(num_threads ? num_threads : DEFAULT_NUM_THREADS) + server->max_suspended);
     options[opt_index++] = "num_threads";
-    options[opt_index++] = "4";
+    options[opt_index++] = server->num_threads;
+    
+    // Persistent connections: each idle keep-alive connection holds a worker thread
+    // until keep_alive_timeout_ms expires, so keep the timeout short
+    if (!find_option(server, "enable_keep_alive")) {
+        options[opt_index++] = "enable_keep_alive";
+        options[opt_index++] = "yes";
+    }
+    if (!find_option(server, "keep_alive_timeout_ms")) {
+        options[opt_index++] = "keep_alive_timeout_ms";
+        options[opt_index++] = DEFAULT_KEEP_ALIVE_TIMEOUT_MS;
+    }
+    
+    for (int i = 0; i < server->num_options; i++) {
+        if (strcmp(server->options[2 * i], "num_threads") == 0) continue;
+        options[opt_index++] = server->options[2 * i];
+        options[opt_index++] = server->options[2 * i + 1];
+    }
     
     options[opt_index] = NULL;
     
-    // Start CivetWeb
-    server->ctx = mg_start(&server->callbacks, NULL, options);
+    // Start CivetWeb (the server handle is the context user data, see request_handler)
+    server->ctx = mg_start(&server->callbacks, server, options);
+    free(options);
     
     if (server->ctx) {
-        // Register WebSocket handlers (Global handlers for all URIs)
-        // Use our internal static handlers that queue events
-        		mg_set_websocket_handler(server->ctx, "/ws", websocket_connect_handler, websocket_ready_handler, websocket_data_handler, websocket_close_handler, NULL);
+        // Register the WebSocket handlers on every configured path. CivetWeb also routes
+        // sub-paths to a handler ("/ws" serves "/ws/chat"); the handlers queue events for Haxe.
+        if (server->num_websocket_paths == 0) {
+            mg_set_websocket_handler(server->ctx, DEFAULT_WEBSOCKET_PATH, websocket_connect_handler, websocket_ready_handler, websocket_data_handler, websocket_close_handler, server);
+        }
+        for (int i = 0; i < server->num_websocket_paths; i++) {
+            mg_set_websocket_handler(server->ctx, server->websocket_paths[i], websocket_connect_handler, websocket_ready_handler, websocket_data_handler, websocket_close_handler, server);
+        }
         
         server->running = 1;
         return true;
@@ -479,12 +2338,249 @@ HL_PRIM bool HL_NAME(start)(hl_civetweb_server *server) {
 HL_PRIM void HL_NAME(stop)(hl_civetweb_server *server) {
     if (!server || !server->running) return;
     
+    // A main loop blocked in wait_for_work returns at once; islands keep waiting for and
+    // answering requests until the workers are gone
+    server->stopping = 1;
+    server->running = 0;
+    mutex_lock(&server->work_mutex);
+    cond_broadcast(&server->work_ready);
+    mutex_unlock(&server->work_mutex);
+    
+    // Both waits are on island threads, which allocate, so wait outside the VM: otherwise a
+    // collection would stall on this thread until every worker timed out
+    hl_blocking(true);
+    
+    // CivetWeb stops writing to sockets once mg_stop begins, so let the requests already in
+    // flight be answered first
+    mutex_lock(&server->response_mutex);
+    long long drain_deadline_ms = now_ms() + STOP_DRAIN_MS;
+    while (requests_to_drain(server) > 0) {
+        long long remaining = drain_deadline_ms - now_ms();
+        if (remaining <= 0) break;
+        cond_wait(&server->drained, &server->response_mutex, remaining);
+    }
+    // Anything still waiting (parked long-polls, unpolled or overdue requests) is answered 503
+    // now instead of holding mg_stop until its deadline
+    for (int i = 0; i < server->slots_used; i++) {
+        queued_request *req = server->response_slots[i].request;
+        if (req && !req->response && !req->streaming) {
+            req->deadline_ms = 0;
+            cond_signal(&req->done);
+        }
+    }
+    mutex_unlock(&server->response_mutex);
+    
     if (server->ctx) {
         mg_stop(server->ctx);
         server->ctx = NULL;
     }
+    hl_blocking(false);
+    server->stopping = 0;
+    
+    // Islands blocked in poll_island return at once instead of sleeping out their timeout
+    for (int i = 0; i < server->num_islands; i++) {
+        mutex_lock(&server->island_queues[i].mutex);
+        cond_broadcast(&server->island_queues[i].ready);
+        mutex_unlock(&server->island_queues[i].mutex);
+    }
+}
+
+// Set a CivetWeb option by name, e.g. "num_threads" or "request_timeout_ms"
+// (must be called before start). Returns false for names CivetWeb does not know.
+HL_PRIM bool HL_NAME(set_option)(hl_civetweb_server *server, vbyte *name, vbyte *value) {
+    if (!server || server->running || !name || !value) return false;
+    
+    const char *opt_name = (const char*)name;
+    const struct mg_option *valid = mg_get_valid_options();
+    while (valid->name && strcmp(valid->name, opt_name) != 0) {
+        valid++;
+    }
+    if (!valid->name) {
+        trace(TRACE_WARN, TRACE_UNKNOWN_OPTION, 0, 0, opt_name);
+        return false;
+    }
     
-    server->running = 0;
+    char *opt_value = strdup((const char*)value);
+    if (!opt_value) return false;
+    
+    // Replace an existing value
+    for (int i = 0; i < server->num_options; i++) {
+        if (strcmp(server->options[2 * i], opt_name) == 0) {
+            free(server->options[2 * i + 1]);
+            server->options[2 * i + 1] = opt_value;
+            return true;
+        }
+    }
+    
+    char **grown = (char**)realloc(server->options, sizeof(char*) * (size_t)(2 * server->num_options + 2));
+    char *opt_name_copy = strdup(opt_name);
+    if (!grown || !opt_name_copy) {
+        if (grown) server->options = grown;
+        free(opt_name_copy);
+        free(opt_value);
+        return false;
+    }
+    server->options = grown;
+    server->options[2 * server->num_options] = opt_name_copy;
+    server->options[2 * server->num_options + 1] = opt_value;
+    server->num_options++;
+    return true;
+}
+
+// Configure HTTP keep-alive (must be called before start)
+HL_PRIM void HL_NAME(set_keep_alive)(hl_civetweb_server *server, bool enabled, int idle_timeout_ms) {
+    if (!server || server->running) return;
+    HL_NAME(set_option)(server, (vbyte*)"enable_keep_alive", (vbyte*)(enabled ? "yes" : "no"));
+    if (idle_timeout_ms > 0) {
+        char timeout_str[32];
+        snprintf(timeout_str, sizeof(timeout_str), "%d", idle_timeout_ms);
+        HL_NAME(set_option)(server, (vbyte*)"keep_alive_timeout_ms", (vbyte*)timeout_str);
+    }
+}
+
+// Cap the size of request bodies; larger requests are answered with 413 (must be called before start)
+HL_PRIM void HL_NAME(set_max_body_size)(hl_civetweb_server *server, int max_bytes) {
+    if (!server || server->running || max_bytes <= 0) return;
+    server->max_body_size = max_bytes;
+}
+
+// Set how many requests may be suspended at once (must be called before start).
+// Each parked request holds one extra CivetWeb worker, spawned on demand.
+HL_PRIM void HL_NAME(set_max_suspended)(hl_civetweb_server *server, int max_suspended) {
+    if (!server || server->running || max_suspended < 0) return;
+    server->max_suspended = max_suspended;
+}
+
+// Worker threads CivetWeb was started with: num_threads plus max_suspended (0 before start)
+HL_PRIM int HL_NAME(get_worker_threads)(hl_civetweb_server *server) {
+    if (!server || !server->running) return 0;
+    return atoi(server->num_threads);
+}
+
+// Set how long workers wait for Haxe before answering 504 (must be called before start)
+HL_PRIM void HL_NAME(set_default_timeout)(hl_civetweb_server *server, int timeout_ms) {
+    if (!server || server->running || timeout_ms <= 0) return;
+    server->default_timeout_ms = timeout_ms;
+}
+
+// Give requests matching a Router pattern their own timeout (must be called before start).
+// Routes are matched in registration order, like Router.find; 0 keeps the default timeout.
+HL_PRIM bool HL_NAME(set_route_timeout)(hl_civetweb_server *server, vbyte *method, vbyte *pattern, int timeout_ms) {
+    if (!server || server->running || !method || !pattern || timeout_ms < 0) return false;
+    
+    route_timeout *grown = (route_timeout*)realloc(server->route_timeouts, sizeof(route_timeout) * (size_t)(server->num_route_timeouts + 1));
+    if (!grown) return false;
+    server->route_timeouts = grown;
+    
+    route_timeout *rt = &server->route_timeouts[server->num_route_timeouts];
+    rt->method = strdup((const char*)method);
+    rt->pattern = strdup((const char*)pattern);
+    if (!rt->method || !rt->pattern) {
+        free(rt->method);
+        free(rt->pattern);
+        return false;
+    }
+    rt->timeout_ms = timeout_ms;
+    server->num_route_timeouts++;
+    return true;
+}
+
+// Serve WebSockets under another path prefix. The first call replaces the default "/ws"
+// (must be called before start).
+HL_PRIM bool HL_NAME(add_websocket_path)(hl_civetweb_server *server, vbyte *path) {
+    if (!server || server->running || !path || ((const char*)path)[0] != '/') return false;
+
+    char **grown = (char**)realloc(server->websocket_paths, sizeof(char*) * (size_t)(server->num_websocket_paths + 1));
+    if (!grown) return false;
+    server->websocket_paths = grown;
+
+    char *copy = strdup((const char*)path);
+    if (!copy) return false;
+    server->websocket_paths[server->num_websocket_paths++] = copy;
+    return true;
+}
+
+// Serve files under a URI prefix from a directory natively (must be called before start).
+// cache_control (optional) is sent with every file and 304 under the mount. Returns false
+// for an invalid prefix or directory.
+HL_PRIM bool HL_NAME(add_static_mount)(hl_civetweb_server *server, vbyte *prefix, vbyte *directory, vbyte *cache_control) {
+    if (!server || server->running || !prefix || !directory) return false;
+    const char *p = (const char*)prefix;
+    const char *d = (const char*)directory;
+    if (p[0] != '/' || d[0] == '\0') return false;
+
+    static_mount *grown = (static_mount*)realloc(server->static_mounts, sizeof(static_mount) * (size_t)(server->num_static_mounts + 1));
+    if (!grown) return false;
+    server->static_mounts = grown;
+
+    // Trailing slashes are dropped so "/assets/" and "/assets" behave the same
+    size_t prefix_len = strlen(p);
+    while (prefix_len > 1 && p[prefix_len - 1] == '/') prefix_len--;
+    size_t dir_len = strlen(d);
+    while (dir_len > 1 && (d[dir_len - 1] == '/' || d[dir_len - 1] == '\\')) dir_len--;
+
+    static_mount *mount = &server->static_mounts[server->num_static_mounts];
+    mount->prefix = (char*)malloc(prefix_len + 1);
+    mount->directory = (char*)malloc(dir_len + 1);
+    mount->cache_control = (cache_control && ((const char*)cache_control)[0]) ? strdup((const char*)cache_control) : NULL;
+    if (!mount->prefix || !mount->directory) {
+        free(mount->prefix);
+        free(mount->directory);
+        free(mount->cache_control);
+        return false;
+    }
+    memcpy(mount->prefix, p, prefix_len);
+    mount->prefix[prefix_len] = '\0';
+    mount->prefix_len = prefix_len;
+    memcpy(mount->directory, d, dir_len);
+    mount->directory[dir_len] = '\0';
+    server->num_static_mounts++;
+    return true;
+}
+
+// Configure gzip for buffered Haxe responses: bodies of at least min_size bytes are
+// compressed at level (1-9). A negative min_size turns it off. Has no effect unless the
+// library was built with USE_ZLIB (must be called before start).
+HL_PRIM void HL_NAME(set_compression)(hl_civetweb_server *server, int min_size, int level) {
+    if (!server || server->running) return;
+    server->compress_min_size = min_size;
+    if (level >= 1 && level <= 9) server->compress_level = level;
+}
+
+// Compress responses whose Content-Type starts with this prefix. The first call replaces
+// the defaults (text/, JSON, JavaScript, XML, SVG); must be called before start.
+HL_PRIM bool HL_NAME(add_compressible_type)(hl_civetweb_server *server, vbyte *prefix) {
+    if (!server || server->running || !prefix || ((const char*)prefix)[0] == '\0') return false;
+
+    char **grown = (char**)realloc(server->compress_types, sizeof(char*) * (size_t)(server->num_compress_types + 1));
+    if (!grown) return false;
+    server->compress_types = grown;
+
+    char *copy = strdup((const char*)prefix);
+    if (!copy) return false;
+    server->compress_types[server->num_compress_types++] = copy;
+    return true;
+}
+
+// Set how long a WebSocket handshake waits for websocket_accept before it is refused
+// (must be called before start).
+HL_PRIM void HL_NAME(set_websocket_accept_timeout)(hl_civetweb_server *server, int timeout_ms) {
+    if (!server || server->running || timeout_ms <= 0) return;
+    server->websocket_accept_timeout_ms = timeout_ms;
+}
+
+// Cap how many WebSocket handshakes may wait for websocket_accept at once; each holds a worker,
+// so further upgrades get 503 straight away (must be called before start).
+HL_PRIM void HL_NAME(set_max_pending_handshakes)(hl_civetweb_server *server, int max_pending) {
+    if (!server || server->running || max_pending <= 0) return;
+    server->ws_handles.max_pending = max_pending;
+}
+
+// Set the request queue high-water mark; past it requests get 503 + Retry-After without
+// reaching Haxe. 0 removes the bound (must be called before start).
+HL_PRIM void HL_NAME(set_max_queue_depth)(hl_civetweb_server *server, int max_depth) {
+    if (!server || server->running || max_depth < 0) return;
+    server->max_queue_depth = max_depth;
 }
 
 // Check if server is running
@@ -512,20 +2608,80 @@ HL_PRIM void HL_NAME(free)(hl_civetweb_server *server) {
     
     if (server->host) free(server->host);
     if (server->document_root) free(server->document_root);
+    for (int i = 0; i < 2 * server->num_options; i++) {
+        free(server->options[i]);
+    }
+    if (server->options) free(server->options);
+    for (int i = 0; i < server->num_route_timeouts; i++) {
+        free(server->route_timeouts[i].method);
+        free(server->route_timeouts[i].pattern);
+    }
+    if (server->route_timeouts) free(server->route_timeouts);
+    for (int i = 0; i < server->num_websocket_paths; i++) {
+        free(server->websocket_paths[i]);
+    }
+    if (server->websocket_paths) free(server->websocket_paths);
+    for (int i = 0; i < server->num_static_mounts; i++) {
+        free(server->static_mounts[i].prefix);
+        free(server->static_mounts[i].directory);
+        free(server->static_mounts[i].cache_control);
+    }
+    if (server->static_mounts) free(server->static_mounts);
+    for (int i = 0; i < server->num_compress_types; i++) {
+        free(server->compress_types[i]);
+    }
+    if (server->compress_types) free(server->compress_types);
+    destroy_request_queue(&server->pending);
+    for (int i = 0; i < server->num_islands; i++) {
+        destroy_request_queue(&server->island_queues[i]);
+    }
+    if (server->island_queues) free(server->island_queues);
+    mutex_destroy(&server->work_mutex);
+    cond_destroy(&server->work_ready);
+#ifndef _WIN32
+    if (server->wakeup_fds[0] >= 0) close(server->wakeup_fds[0]);
+    if (server->wakeup_fds[1] >= 0 && server->wakeup_fds[1] != server->wakeup_fds[0]) close(server->wakeup_fds[1]);
+#endif
+    mutex_destroy(&server->response_mutex);
+    cond_destroy(&server->drained);
+    mutex_destroy(&server->ws_handles.mutex);
+    cond_destroy(&server->ws_handles.decided);
+    cond_destroy(&server->ws_handles.unpinned);
     free(server);
 }
 
-// WebSocket send data
-HL_PRIM int HL_NAME(websocket_send)(vbyte *conn, int opcode, vbyte *data, int data_len) {
-    if (!conn || !data) return -1;
-    return mg_websocket_write((struct mg_connection*)conn, opcode, (const char*)data, data_len);
+// Accept or reject a pending WebSocket handshake (the CONNECT event's connId). Returns false
+// if the handshake already timed out.
+HL_PRIM bool HL_NAME(websocket_accept)(hl_civetweb_server *server, int conn_id, bool accept) {
+    if (!server || conn_id <= 0) return false;
+    bool pending = false;
+    mutex_lock(&server->ws_handles.mutex);
+    ws_handle *handle = &server->ws_handles.handles[conn_id & WS_HANDLE_MASK];
+    if (handle->id == conn_id && handle->decision == 0) {
+        handle->decision = accept ? 1 : -1;
+        pending = true;
+        cond_broadcast(&server->ws_handles.decided);
+    }
+    mutex_unlock(&server->ws_handles.mutex);
+    return pending;
+}
+
+// WebSocket send data. Returns -1 without writing if the connection has already closed.
+HL_PRIM int HL_NAME(websocket_send)(hl_civetweb_server *server, int conn_id, int opcode, vbyte *data, int data_len) {
+    if (!server || !data) return -1;
+    struct mg_connection *conn = pin_websocket(&server->ws_handles, conn_id);
+    if (!conn) return -1;
+    // A full socket buffer blocks only this caller, and outside the VM so collections go on
+    hl_blocking(true);
+    int result = mg_websocket_write(conn, opcode, (const char*)data, data_len);
+    hl_blocking(false);
+    unpin_websocket(&server->ws_handles, conn_id);
+    return result;
 }
 
-// WebSocket close connection
-HL_PRIM void HL_NAME(websocket_close)(vbyte *conn, int code, vbyte *reason) {
-    if (!conn) return;
-    
-    struct mg_connection *m_conn = (struct mg_connection*)conn;
+// WebSocket close connection (no-op if it has already closed)
+HL_PRIM void HL_NAME(websocket_close)(hl_civetweb_server *server, int conn_id, int code, vbyte *reason) {
+    if (!server) return;
     
     // Send close frame with code and reason
     char close_data[128];
@@ -539,166 +2695,764 @@ HL_PRIM void HL_NAME(websocket_close)(vbyte *conn, int code, vbyte *reason) {
     // Add reason if provided
     if (reason) {
         int reason_len = strlen((const char*)reason);
-        if (reason_len > 125) reason_len = 125;
+        if (reason_len > 123) reason_len = 123;
         memcpy(close_data + 2, reason, reason_len);
         close_len += reason_len;
     }
     
-    mg_websocket_write((struct mg_connection*)conn, 0x8, close_data, close_len);  // 0x8 = close frame
+    struct mg_connection *conn = pin_websocket(&server->ws_handles, conn_id);
+    if (!conn) return;
+    hl_blocking(true);
+    mg_websocket_write(conn, 0x8, close_data, close_len);  // 0x8 = close frame
+    hl_blocking(false);
+    unpin_websocket(&server->ws_handles, conn_id);
+}
+
+// Helper: Frame a payload once as an unmasked server-to-client WebSocket frame (RFC 6455
+// section 5.2) so it can be written verbatim to many connections. Returns NULL on OOM.
+// Only valid while permessage-deflate is off (civetweb.c is built without USE_ZLIB).
+static char* build_websocket_frame(int opcode, const char *data, size_t data_len, size_t *frame_len) {
+    unsigned char header[10];
+    size_t header_len;
+    header[0] = 0x80 | (unsigned char)(opcode & 0x0F);   // FIN + opcode
+    if (data_len < 126) {
+        header[1] = (unsigned char)data_len;
+        header_len = 2;
+    } else if (data_len <= 0xFFFF) {
+        header[1] = 126;
+        header[2] = (unsigned char)(data_len >> 8);
+        header[3] = (unsigned char)data_len;
+        header_len = 4;
+    } else {
+        header[1] = 127;
+        for (int i = 0; i < 8; i++) {
+            header[2 + i] = (unsigned char)((unsigned long long)data_len >> (56 - 8 * i));
+        }
+        header_len = 10;
+    }
+
+    char *frame = (char*)pool_alloc(header_len + data_len);
+    if (!frame) return NULL;
+    memcpy(frame, header, header_len);
+    if (data_len > 0) memcpy(frame + header_len, data, data_len);
+    *frame_len = header_len + data_len;
+    return frame;
+}
+
+// WebSocket broadcast: frame data once and write it to every live connection in ids
+// (a NativeArray<Int> of connection ids; closed ids are skipped). Returns the number of
+// connections the whole frame was written to.
+HL_PRIM int HL_NAME(websocket_broadcast)(hl_civetweb_server *server, varray *ids, int count, int opcode, vbyte *data, int data_len) {
+    if (!server || !ids || (!data && data_len > 0) || data_len < 0) return 0;
+    if (count > ids->size) count = ids->size;
+    if (count <= 0) return 0;
+
+    size_t frame_len;
+    char *frame = build_websocket_frame(opcode, (const char*)data, (size_t)data_len, &frame_len);
+    struct mg_connection **conns = (struct mg_connection**)pool_alloc((size_t)count * sizeof(*conns));
+    if (!frame || !conns) {
+        pool_free(frame);
+        pool_free(conns);
+        return 0;
+    }
+
+    // Pin every live recipient in one pass, then write without the table's mutex: a client
+    // with a full socket buffer delays only this broadcast, never other sends or handshakes
+    int *conn_ids = hl_aptr(ids, int);
+    mutex_lock(&server->ws_handles.mutex);
+    for (int i = 0; i < count; i++) {
+        conns[i] = lookup_websocket(&server->ws_handles, conn_ids[i]);
+        if (conns[i]) server->ws_handles.handles[conn_ids[i] & WS_HANDLE_MASK].pins++;
+    }
+    mutex_unlock(&server->ws_handles.mutex);
+
+    int delivered = 0;
+    hl_blocking(true);
+    for (int i = 0; i < count; i++) {
+        if (!conns[i]) continue;
+        // Same per-connection lock mg_websocket_write takes, so frames never interleave
+        mg_lock_connection(conns[i]);
+        if (mg_write(conns[i], frame, frame_len) == (int)frame_len) delivered++;
+        mg_unlock_connection(conns[i]);
+        unpin_websocket(&server->ws_handles, conn_ids[i]);
+    }
+    hl_blocking(false);
+
+    pool_free(conns);
+    pool_free(frame);
+    return delivered;
 }
 
 // ============================================================================
 // POLLING ARCHITECTURE: Native Functions for Haxe
 // ============================================================================
 
-// Poll for pending requests (called from Haxe main thread)
-HL_PRIM vdynamic* HL_NAME(poll_request)(hl_civetweb_server *server) {
-    if (!server) return NULL;
-    
-    lock_request_mutex();
+// Helper: Dequeue the next request from a queue (its mutex must be held)
+static queued_request* dequeue_request(hl_civetweb_server *server, request_queue *queue) {
+    queued_request *curr = queue->head;
+    if (!curr) return NULL;
+    queue->head = curr->next;
+    if (queue->head == NULL) {
+        queue->tail = NULL;
+    }
+    queue->depth--;
+    atomic_add(&server->queue_depth, -1);
+    return curr;
+}
+
+// Helper: Count the gap since the previous poll of a queue (its mutex must be held)
+static long long record_poll(hl_civetweb_server *server, request_queue *queue) {
+    long long now = now_us();
+    if (queue->last_poll_us > 0) record_latency(server->latency, STAGE_POLL_INTERVAL, now - queue->last_poll_us);
+    queue->last_poll_us = now;
+    return now;
+}
+
+// Helper: Copy a dequeued request into a Haxe request record (the queue's mutex must be held,
+// since a timed-out worker frees its request once it can no longer be polled)
+static void fill_request_record(hl_civetweb_server *server, hl_request_record *record, queued_request *curr, long long now) {
+    atomic_store_release(&curr->polled_us, now);
+    record_latency(server->latency, STAGE_QUEUE_WAIT, now - curr->enqueued_us);
+    // Copy string fields to new HL-managed memory
+    record->id = curr->request_id;
+    record->body_length = curr->body_length;
+    record->uri = hl_copy_bytes((vbyte*)curr->uri, (int)strlen(curr->uri) + 1);
+    record->method = hl_copy_bytes((vbyte*)curr->method, (int)strlen(curr->method) + 1);
+    record->body = curr->body ? hl_copy_bytes((vbyte*)curr->body, curr->body_length + 1) : NULL;
+    record->query_string = hl_copy_bytes((vbyte*)curr->query_string, (int)strlen(curr->query_string) + 1);
+    record->remote_addr = hl_copy_bytes((vbyte*)curr->remote_addr, (int)strlen(curr->remote_addr) + 1);
+    record->headers = hl_copy_bytes((vbyte*)curr->headers, (int)strlen(curr->headers) + 1);
+}
+
+// Helper: Build a response for a request ID (content type, headers and body are copied)
+static queued_response* alloc_response(int request_id, int status_code, vbyte *content_type, vbyte *headers, vbyte *body, int body_length) {
+    const char *ct = content_type ? (const char*)content_type : "text/html; charset=utf-8";
+    const char *hdrs = headers ? (const char*)headers : "";
+    size_t ct_len = strlen(ct);
+    size_t hdrs_len = strlen(hdrs);
+    if (!body || body_length < 0) body_length = 0;
+    
+    // Allocate response sized to the actual content type, headers and body
+    queued_response *resp = (queued_response*)pool_alloc(sizeof(queued_response) + ct_len + 1 + hdrs_len + 1 + (size_t)body_length);
+    if (!resp) return NULL;
     
-    if (!g_request_queue_head) {
-        unlock_request_mutex();
-        return NULL;
+    resp->request_id = request_id;
+    resp->status_code = status_code;
+    resp->content_type = (char*)(resp + 1);
+    memcpy(resp->content_type, ct, ct_len + 1);
+    resp->headers = resp->content_type + ct_len + 1;
+    memcpy(resp->headers, hdrs, hdrs_len + 1);
+    resp->body = resp->headers + hdrs_len + 1;
+    resp->body_length = body_length;
+    if (body_length > 0) {
+        memcpy(resp->body, body, body_length);
+    }
+    return resp;
+}
+
+// Helper: Timestamp the moment Haxe answers a request (response mutex must be held)
+static void mark_responded(hl_civetweb_server *server, queued_request *req) {
+    req->responded_us = now_us();
+    long long polled_us = atomic_load_acquire(&req->polled_us);
+    if (polled_us > 0) record_latency(server->latency, STAGE_PROCESSING, req->responded_us - polled_us);
+}
+
+// Helper: Hand a response to its waiting worker and wake it (response mutex must be held).
+// Returns 0 and leaves ownership with the caller if the request is no longer waiting.
+static int deliver_response(hl_civetweb_server *server, queued_response *resp) {
+    queued_request *waiting = find_waiting_request(server, resp->request_id);
+    if (!waiting || waiting->response || waiting->streaming) {
+        trace(TRACE_WARN, TRACE_RESPONSE_DROPPED, resp->request_id, 0, NULL);
+        return 0;
     }
+    mark_responded(server, waiting);
+    waiting->response = resp;
+    cond_signal(&waiting->done);
+    return 1;
+}
+
+// Poll for a pending request into a caller-provided record (called from Haxe main thread).
+// Returns false when the queue is empty.
+HL_PRIM bool HL_NAME(poll_request)(hl_civetweb_server *server, hl_request_record *record) {
+    if (!server || !record) return false;
+    
+    request_queue *queue = &server->pending;
+    mutex_lock(&queue->mutex);
+    long long now = record_poll(server, queue);
     
     // Dequeue one request
-    queued_request *curr = g_request_queue_head;
-    printf("[CivetWebNative] Polling request ID %d\n", curr->request_id);
-    fflush(stdout);
-    g_request_queue_head = curr->next;
-    if (g_request_queue_head == NULL) {
-        g_request_queue_tail = NULL;
+    queued_request *curr = dequeue_request(server, queue);
+    if (!curr) {
+        mutex_unlock(&queue->mutex);
+        return false;
     }
+    trace(TRACE_DEBUG, TRACE_REQUEST_POLLED, curr->request_id, 0, NULL);
     
-    // Create dynamic object for this request
-    vdynamic *obj = (vdynamic*)hl_alloc_dynobj();
+    fill_request_record(server, record, curr, now);
+    
+    mutex_unlock(&queue->mutex);
+    
+    return true;
+}
 
-    // Copy string fields to new HL-managed memory
-    vbyte *uri_bytes = curr->uri ? hl_copy_bytes((vbyte*)curr->uri, (int)strlen(curr->uri) + 1) : NULL;
-    vbyte *method_bytes = curr->method ? hl_copy_bytes((vbyte*)curr->method, (int)strlen(curr->method) + 1) : NULL;
-    vbyte *body_bytes = curr->body ? hl_copy_bytes((vbyte*)curr->body, curr->body_length + 1) : NULL;
-    vbyte *query_bytes = curr->query_string ? hl_copy_bytes((vbyte*)curr->query_string, (int)strlen(curr->query_string) + 1) : NULL;
-    vbyte *remote_bytes = curr->remote_addr ? hl_copy_bytes((vbyte*)curr->remote_addr, (int)strlen(curr->remote_addr) + 1) : NULL;
-    vbyte *headers_bytes = curr->headers ? hl_copy_bytes((vbyte*)curr->headers, (int)strlen(curr->headers) + 1) : NULL;
+// Poll up to max pending requests into caller-provided records under a single lock
+// acquisition (called from Haxe main thread). Returns the number of records filled.
+HL_PRIM int HL_NAME(poll_requests)(hl_civetweb_server *server, varray *records, int max) {
+    if (!server || !records) return 0;
+    if (max > records->size) max = records->size;
+    
+    request_queue *queue = &server->pending;
+    mutex_lock(&queue->mutex);
+    long long now = record_poll(server, queue);
+    
+    int count = 0;
+    while (count < max && queue->head) {
+        hl_request_record *record = hl_aptr(records, hl_request_record*)[count];
+        if (!record) break;
+        fill_request_record(server, record, dequeue_request(server, queue), now);
+        count++;
+    }
     
-    // Set fields
-    hl_dyn_seti(obj, hl_hash_utf8("id"), &hlt_i32, curr->request_id);
-    hl_dyn_setp(obj, hl_hash_utf8("uri"), &hlt_bytes, uri_bytes);
-    hl_dyn_setp(obj, hl_hash_utf8("method"), &hlt_bytes, method_bytes);
-    hl_dyn_setp(obj, hl_hash_utf8("body"), &hlt_bytes, body_bytes);
-    hl_dyn_seti(obj, hl_hash_utf8("bodyLength"), &hlt_i32, curr->body_length);
-    hl_dyn_setp(obj, hl_hash_utf8("queryString"), &hlt_bytes, query_bytes);
-    hl_dyn_setp(obj, hl_hash_utf8("remoteAddr"), &hlt_bytes, remote_bytes);
-    hl_dyn_setp(obj, hl_hash_utf8("headers"), &hlt_bytes, headers_bytes);
+    mutex_unlock(&queue->mutex);
     
-    unlock_request_mutex();
+    return count;
+}
+
+// Give each of count WorkerIslands its own request queue (must be called before start).
+// Requests then skip the shared queue: poll_requests finds nothing and each island calls
+// poll_island for its own. 0 goes back to the shared queue.
+HL_PRIM bool HL_NAME(set_islands)(hl_civetweb_server *server, int count) {
+    if (!server || server->running || count < 0) return false;
+    
+    request_queue *queues = NULL;
+    if (count > 0) {
+        queues = (request_queue*)malloc(sizeof(request_queue) * (size_t)count);
+        if (!queues) return false;
+        for (int i = 0; i < count; i++) {
+            init_request_queue(&queues[i]);
+        }
+    }
+    for (int i = 0; i < server->num_islands; i++) {
+        destroy_request_queue(&server->island_queues[i]);
+    }
+    if (server->island_queues) free(server->island_queues);
+    server->island_queues = queues;
+    server->num_islands = count;
+    return true;
+}
+
+// Wait up to timeout_ms for requests on one island's queue, then poll up to max of them into
+// caller-provided records (called from that island's thread). Returns the number filled.
+HL_PRIM int HL_NAME(poll_island)(hl_civetweb_server *server, int island, varray *records, int max, int timeout_ms) {
+    if (!server || !records || island < 0 || island >= server->num_islands) return 0;
+    if (max > records->size) max = records->size;
+    request_queue *queue = &server->island_queues[island];
+    
+    // Wait outside the VM so an idle island never holds up a collection
+    hl_blocking(true);
+    mutex_lock(&queue->mutex);
+    long long deadline_ms = now_ms() + timeout_ms;
+    while (!queue->head && (server->running || server->stopping)) {
+        long long remaining = deadline_ms - now_ms();
+        if (remaining <= 0) break;
+        cond_wait(&queue->ready, &queue->mutex, remaining);
+    }
+    mutex_unlock(&queue->mutex);
+    hl_blocking(false);
+    
+    // Copying allocates, so it happens back inside the VM. Only this island's thread polls the
+    // queue from Haxe, so a collection can never wait on a thread blocked on this lock.
+    mutex_lock(&queue->mutex);
+    long long now = record_poll(server, queue);
+    int count = 0;
+    while (count < max && queue->head) {
+        hl_request_record *record = hl_aptr(records, hl_request_record*)[count];
+        if (!record) break;
+        fill_request_record(server, record, dequeue_request(server, queue), now);
+        count++;
+    }
+    mutex_unlock(&queue->mutex);
     
-    return obj;
+    return count;
+}
+
+// Block the calling (main) thread for up to timeout_ms until a request reaches the shared queue
+// or a WebSocket event is queued, so the main loop can sleep between handleRequest calls instead
+// of spinning. Returns true if work arrived since the last call, false on timeout or once the
+// server stops. A timeout of 0 only checks (and rearms the wakeup fd).
+HL_PRIM bool HL_NAME(wait_for_work)(hl_civetweb_server *server, int timeout_ms) {
+    if (!server) return false;
+    
+    drain_wakeup_fd(server);
+    if (atomic_exchange(&server->work_signaled, 0)) return true;
+    if (timeout_ms <= 0 || !server->running) return false;
+    
+    // Wait outside the VM so an idle main loop never holds up a collection
+    hl_blocking(true);
+    mutex_lock(&server->work_mutex);
+    long long deadline_ms = now_ms() + timeout_ms;
+    bool signaled = false;
+    while (server->running) {
+        signaled = atomic_exchange(&server->work_signaled, 0) != 0;
+        if (signaled) break;
+        long long remaining = deadline_ms - now_ms();
+        if (remaining <= 0) break;
+        cond_wait(&server->work_ready, &server->work_mutex, remaining);
+    }
+    mutex_unlock(&server->work_mutex);
+    hl_blocking(false);
+    return signaled;
+}
+
+// File descriptor that becomes readable whenever wait_for_work would return true, for event loops
+// that poll descriptors themselves (an eventfd on Linux, a pipe elsewhere). Once it fires, call
+// wait_for_work with timeout 0 to rearm it. First call must come before start; -1 on Windows.
+HL_PRIM int HL_NAME(get_wakeup_fd)(hl_civetweb_server *server) {
+    if (!server) return -1;
+#ifdef _WIN32
+    return -1;
+#else
+    if (server->wakeup_fds[0] >= 0 || server->running) return server->wakeup_fds[0];
+#if defined(__linux__)
+    int fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (fd < 0) return -1;
+    server->wakeup_fds[0] = server->wakeup_fds[1] = fd;
+#else
+    int fds[2];
+    if (pipe(fds) != 0) return -1;
+    for (int i = 0; i < 2; i++) {
+        fcntl(fds[i], F_SETFL, fcntl(fds[i], F_GETFL) | O_NONBLOCK);
+        fcntl(fds[i], F_SETFD, FD_CLOEXEC);
+    }
+    server->wakeup_fds[0] = fds[0];
+    server->wakeup_fds[1] = fds[1];
+#endif
+    return server->wakeup_fds[0];
+#endif
 }
 
-// Push a response for a request ID (called from Haxe main thread)
-HL_PRIM void HL_NAME(push_response)(hl_civetweb_server *server, int request_id, int status_code, vbyte *content_type, vbyte *body, int body_length) {
+// Push a response for a request ID (called from Haxe island threads).
+// headers is an optional "Name: value\n" block sent as-is (except framing headers).
+HL_PRIM void HL_NAME(push_response)(hl_civetweb_server *server, int request_id, int status_code, vbyte *content_type, vbyte *headers, vbyte *body, int body_length) {
     if (!server) return;
     
-    // Allocate response
-    queued_response *resp = (queued_response*)malloc(sizeof(queued_response));
+    queued_response *resp = alloc_response(request_id, status_code, content_type, headers, body, body_length);
     if (!resp) return;
     
-    memset(resp, 0, sizeof(queued_response));
-    printf("[CivetWebNative] Pushing response for ID %d (len %d)\n", request_id, body_length);
-    fflush(stdout);
-    resp->request_id = request_id;
-    resp->status_code = status_code;
-    resp->body_length = body_length;
+    trace(TRACE_DEBUG, TRACE_RESPONSE_PUSHED, request_id, resp->body_length, NULL);
     
-    // Copy data with bounds checking
-    if (content_type) {
-        strncpy(resp->content_type, (const char*)content_type, sizeof(resp->content_type) - 1);
-    } else {
-        strncpy(resp->content_type, "text/html; charset=utf-8", sizeof(resp->content_type) - 1);
+    mutex_lock(&server->response_mutex);
+    int delivered = deliver_response(server, resp);
+    mutex_unlock(&server->response_mutex);
+
+    if (!delivered) pool_free(resp);
+}
+
+// Push several responses at once; all are delivered under a single lock acquisition
+HL_PRIM void HL_NAME(push_responses)(hl_civetweb_server *server, int count, varray *request_ids, varray *status_codes, varray *content_types, varray *headers, varray *bodies, varray *body_lengths) {
+    if (!server || count <= 0 || !request_ids || !status_codes || !bodies || !body_lengths) return;
+    if (count > request_ids->size || count > status_codes->size || count > bodies->size || count > body_lengths->size) return;
+    if ((content_types && count > content_types->size) || (headers && count > headers->size)) return;
+    
+    queued_response **resps = (queued_response**)malloc(sizeof(queued_response*) * (size_t)count);
+    if (!resps) return;
+    
+    // Copy everything out of HL memory before taking the lock
+    for (int i = 0; i < count; i++) {
+        resps[i] = alloc_response(hl_aptr(request_ids, int)[i],
+                                  hl_aptr(status_codes, int)[i],
+                                  content_types ? hl_aptr(content_types, vbyte*)[i] : NULL,
+                                  headers ? hl_aptr(headers, vbyte*)[i] : NULL,
+                                  hl_aptr(bodies, vbyte*)[i],
+                                  hl_aptr(body_lengths, int)[i]);
     }
     
-    if (body && body_length > 0) {
-        int copy_len = body_length < sizeof(resp->body) ? body_length : sizeof(resp->body) - 1;
-        memcpy(resp->body, body, copy_len);
-        resp->body_length = copy_len;
+    mutex_lock(&server->response_mutex);
+    for (int i = 0; i < count; i++) {
+        if (resps[i] && deliver_response(server, resps[i])) {
+            resps[i] = NULL;
+        }
     }
+    mutex_unlock(&server->response_mutex);
     
-    // Enqueue response
+    for (int i = 0; i < count; i++) {
+        if (resps[i]) pool_free(resps[i]);
+    }
+    free(resps);
+}
 
-    lock_response_mutex();
-    resp->next = NULL;
-    if (g_response_queue_tail) {
-        g_response_queue_tail->next = resp;
-    } else {
-        g_response_queue_head = resp;
+// Park a request that Haxe will hold open, e.g. a long-poll (called from Haxe main or island threads).
+// Its worker waits up to timeout_ms for the response instead of the usual 30 seconds and counts
+// against max_suspended rather than the regular worker pool.
+// Returns false if the request is no longer waiting or max_suspended requests are already parked;
+// the caller should then answer right away.
+HL_PRIM bool HL_NAME(suspend_request)(hl_civetweb_server *server, int request_id, int timeout_ms) {
+    if (!server || timeout_ms <= 0) return false;
+    
+    mutex_lock(&server->response_mutex);
+    queued_request *req = find_waiting_request(server, request_id);
+    int parked = 0;
+    if (req && !req->response && !req->streaming
+        && (req->suspended || server->suspended_count < server->max_suspended)) {
+        if (!req->suspended) {
+            req->suspended = 1;
+            server->suspended_count++;
+            if (server->stopping) cond_broadcast(&server->drained);
+        }
+        req->deadline_ms = now_ms() + timeout_ms;
+        cond_signal(&req->done);
+        parked = 1;
     }
-    g_response_queue_tail = resp;
-    printf("[CivetWebNative] Response for ID %d enqueued\n", request_id);
-    fflush(stdout);
-    unlock_response_mutex();
+    mutex_unlock(&server->response_mutex);
+    return parked;
 }
 
-// Poll for pending WebSocket events (called from Haxe main thread)
-HL_PRIM vdynamic* HL_NAME(poll_websocket_event)(hl_civetweb_server *server) {
-    if (!server) return NULL;
+// Snapshot queue metrics into a caller-provided record (safe from any thread)
+HL_PRIM void HL_NAME(get_queue_stats)(hl_civetweb_server *server, hl_queue_stats *stats) {
+    if (!server || !stats) return;
+    
+    stats->depth = (int)atomic_load_acquire(&server->queue_depth);
+    stats->rejected = (int)atomic_load_acquire(&server->rejected_count);
+    stats->ws_events_dropped = (int)atomic_load_acquire(&server->ws_events_dropped);
+    stats->max_depth = server->max_queue_depth;
+    
+    // The queue locks are held while polls copy into HL memory; wait for them outside the VM
+    hl_blocking(true);
+    long long oldest_ms = 0;
+    for (int i = -1; i < server->num_islands; i++) {
+        request_queue *queue = i < 0 ? &server->pending : &server->island_queues[i];
+        mutex_lock(&queue->mutex);
+        if (queue->head && (oldest_ms == 0 || queue->head->enqueued_ms < oldest_ms)) oldest_ms = queue->head->enqueued_ms;
+        mutex_unlock(&queue->mutex);
+    }
+    hl_blocking(false);
+    stats->oldest_age_ms = oldest_ms > 0 ? (int)(now_ms() - oldest_ms) : 0;
+}
+
+// Summarize the per-stage latency histograms into caller-provided records, in STAGE_* order
+// (safe from any thread). With reset, the histograms start over, so successive calls cover
+// successive intervals. Returns the number of records filled.
+HL_PRIM int HL_NAME(get_stats)(hl_civetweb_server *server, varray *stages, bool reset) {
+    if (!server || !stages) return 0;
+    int count = stages->size < STAGE_COUNT ? stages->size : STAGE_COUNT;
+    for (int i = 0; i < count; i++) {
+        hl_stage_stats *stats = hl_aptr(stages, hl_stage_stats*)[i];
+        if (!stats) return i;
+        snapshot_latency(server->latency, i, stats, reset);
+    }
+    return count;
+}
+
+// CivetWeb's own server statistics as a JSON object: memory, connections (active, maxActive,
+// total), accept queue (length, filled, maxFilled), requests, bytes read/written and uptime.
+// Returns null unless civetweb.c was built with USE_SERVER_STATS.
+HL_PRIM vbyte* HL_NAME(get_context_info)(hl_civetweb_server *server) {
+    if (!server || !server->ctx) return NULL;
+#if defined(USE_SERVER_STATS)
+    // Size the buffer with a dry run; the slack covers counters growing a digit in between
+    int length = mg_get_context_info(server->ctx, NULL, 0);
+    if (length <= 0) return NULL;
+    char *buffer = (char*)malloc((size_t)length + 256);
+    if (!buffer) return NULL;
+    mg_get_context_info(server->ctx, buffer, length + 256);
+    vbyte *info = hl_copy_bytes((vbyte*)buffer, (int)strlen(buffer) + 1);
+    free(buffer);
+    return info;
+#else
+    return NULL;
+#endif
+}
+
+// State of worker thread `index` as a JSON object: state, remote address, handled requests,
+// current request, connection age in seconds and bytes moved. Returns null past the last worker,
+// or unless built with USE_SERVER_STATS and MG_EXPERIMENTAL_INTERFACES.
+HL_PRIM vbyte* HL_NAME(get_connection_info)(hl_civetweb_server *server, int index) {
+    if (!server || !server->ctx || index < 0) return NULL;
+#if defined(USE_SERVER_STATS) && defined(MG_EXPERIMENTAL_INTERFACES)
+    char buffer[4096];
+    if (mg_get_connection_info(server->ctx, index, buffer, sizeof(buffer)) <= 0) return NULL;
+    return hl_copy_bytes((vbyte*)buffer, (int)strlen(buffer) + 1);
+#else
+    return NULL;
+#endif
+}
+
+// Start a streamed response for a request ID (called from Haxe island threads).
+// The status line and headers are sent with chunked framing; follow with push_chunk and end_response.
+// Returns false if the request is no longer waiting or already has a response.
+HL_PRIM bool HL_NAME(begin_response)(hl_civetweb_server *server, int request_id, int status_code, vbyte *content_type, vbyte *headers) {
+    if (!server) return false;
+    
+    queued_response *resp = alloc_response(request_id, status_code, content_type, headers, NULL, 0);
+    if (!resp) return false;
+    
+    mutex_lock(&server->response_mutex);
+    queued_request *waiting = find_waiting_request(server, request_id);
+    int started = 0;
+    if (waiting && !waiting->response && !waiting->streaming) {
+        mark_responded(server, waiting);
+        waiting->streaming = 1;
+        waiting->response = resp;
+        cond_signal(&waiting->done);
+        started = 1;
+    }
+    mutex_unlock(&server->response_mutex);
     
-    lock_websocket_mutex();
+    if (!started) pool_free(resp);
+    return started;
+}
+
+// Queue a piece of a streamed response body (called from Haxe island threads).
+// Blocks while the connection is STREAM_BACKLOG_LIMIT bytes behind, so a slow client
+// throttles the producer instead of buffering the whole body.
+// Returns false once the stream is closed (ended, timed out or the client went away).
+HL_PRIM bool HL_NAME(push_chunk)(hl_civetweb_server *server, int request_id, vbyte *data, int length) {
+    if (!server || length < 0 || (length > 0 && !data)) return false;
+    
+    // A zero-length chunk would terminate the body early
+    response_chunk *chunk = NULL;
+    if (length > 0) {
+        chunk = (response_chunk*)pool_alloc(sizeof(response_chunk) + (size_t)length);
+        if (!chunk) return false;
+        chunk->next = NULL;
+        chunk->length = length;
+        memcpy(chunk + 1, data, (size_t)length);
+    }
     
-    if (!g_websocket_queue_head) {
-        unlock_websocket_mutex();
-        return NULL;
+    mutex_lock(&server->response_mutex);
+    queued_request *req = find_waiting_request(server, request_id);
+    if (!req || !req->streaming || req->stream_ended) {
+        mutex_unlock(&server->response_mutex);
+        if (chunk) pool_free(chunk);
+        return false;
     }
     
-    // Dequeue one event
-    queued_websocket_event *curr = g_websocket_queue_head;
-    g_websocket_queue_head = curr->next;
-    if (g_websocket_queue_head == NULL) {
-        g_websocket_queue_tail = NULL;
+    while (chunk && req->chunk_bytes > 0 && req->chunk_bytes + (size_t)length > STREAM_BACKLOG_LIMIT && !req->stream_closed) {
+        req->stream_waiters++;
+        cond_wait(&req->drained, &server->response_mutex, 1000);
+        req->stream_waiters--;
+    }
+    if (req->stream_closed) {
+        // Let the worker free the request once the last producer is out
+        if (req->stream_waiters == 0) cond_signal(&req->done);
+        mutex_unlock(&server->response_mutex);
+        if (chunk) pool_free(chunk);
+        return false;
+    }
+    
+    if (chunk) {
+        if (req->chunks_tail) {
+            req->chunks_tail->next = chunk;
+        } else {
+            req->chunks_head = chunk;
+        }
+        req->chunks_tail = chunk;
+        req->chunk_bytes += (size_t)length;
+        cond_signal(&req->done);
+    }
+    mutex_unlock(&server->response_mutex);
+    return true;
+}
+
+// Finish a streamed response (called from Haxe island threads). Queued chunks are still written.
+HL_PRIM bool HL_NAME(end_response)(hl_civetweb_server *server, int request_id) {
+    if (!server) return false;
+    
+    mutex_lock(&server->response_mutex);
+    queued_request *req = find_waiting_request(server, request_id);
+    int ended = 0;
+    if (req && req->streaming && !req->stream_ended) {
+        req->stream_ended = 1;
+        cond_signal(&req->done);
+        ended = 1;
     }
+    mutex_unlock(&server->response_mutex);
+    return ended;
+}
+
+// Poll for one pending WebSocket event (called from Haxe main thread).
+// Prefer poll_websocket_events, which drains in batches without building dynamic objects.
+HL_PRIM vdynamic* HL_NAME(poll_websocket_event)(hl_civetweb_server *server) {
+    if (!server) return NULL;
+    
+    long long pos;
+    ws_ring_cell *cell = claim_websocket_cell(&server->ws_events, &pos);
+    if (!cell) return NULL;
     
     // Create dynamic object for this event
     vdynamic *obj = (vdynamic*)hl_alloc_dynobj();
+    const char *payload = cell->overflow ? cell->overflow : cell->data;
 
     // Set fields
-    hl_dyn_seti(obj, hl_hash_utf8("type"), &hlt_i32, curr->type);
+    hl_dyn_seti(obj, hl_hash_utf8("type"), &hlt_i32, cell->type);
     
-    // Connection pointer (direct assignment to dynamic field)
-    hl_dyn_setp(obj, hl_hash_utf8("conn"), &hlt_bytes, (vbyte*)curr->conn);
+    hl_dyn_seti(obj, hl_hash_utf8("connId"), &hlt_i32, cell->conn_id);
 
-    hl_dyn_seti(obj, hl_hash_utf8("flags"), &hlt_i32, curr->flags);
+    hl_dyn_seti(obj, hl_hash_utf8("flags"), &hlt_i32, cell->flags);
     
-    if (curr->data) {
-        vbyte *data_bytes = hl_copy_bytes((vbyte*)curr->data, curr->data_len + 1);
+    if (cell->data_len > 0) {
+        vbyte *data_bytes = hl_copy_bytes((const vbyte*)payload, cell->data_len + 1);
         hl_dyn_setp(obj, hl_hash_utf8("data"), &hlt_bytes, data_bytes);
-        hl_dyn_seti(obj, hl_hash_utf8("dataLength"), &hlt_i32, curr->data_len);
+        hl_dyn_seti(obj, hl_hash_utf8("dataLength"), &hlt_i32, cell->data_len);
     } else {
         hl_dyn_setp(obj, hl_hash_utf8("data"), &hlt_bytes, NULL);
         hl_dyn_seti(obj, hl_hash_utf8("dataLength"), &hlt_i32, 0);
     }
     
-    // Free the queued event structure
-    if (curr->data) free(curr->data);
-    free(curr);
-    
-    unlock_websocket_mutex();
+    release_websocket_cell(cell, pos);
     
     return obj;
 }
 
+// Change the minimum level recorded by native tracing (0 debug .. 3 error, 4 off). Takes effect
+// immediately on every thread; events already buffered are still drained.
+HL_PRIM void HL_NAME(set_trace_level)(int level) {
+    if (level < TRACE_DEBUG) level = TRACE_DEBUG;
+    if (level > TRACE_OFF) level = TRACE_OFF;
+    g_trace_level = level;
+}
+
+// Drain up to max buffered trace events from every thread's ring into caller-provided records
+// (called from one Haxe thread at a time). Events lost to a full ring are reported as a single
+// warning per ring. Returns the number of records filled.
+HL_PRIM int HL_NAME(drain_trace)(varray *records, int max) {
+    if (!records) return 0;
+    if (max > records->size) max = records->size;
+    
+    init_process_mutexes(); // May be called before any server exists
+    mutex_lock(&g_trace_mutex);
+    trace_ring *ring = g_trace_rings;
+    mutex_unlock(&g_trace_mutex);
+    
+    long long now = now_ms();
+    int count = 0;
+    // Rings are only ever prepended, so the list from the snapshot onward is stable
+    for (; ring && count < max; ring = ring->next) {
+        long long dropped = atomic_load_acquire(&ring->dropped);
+        if (dropped > ring->dropped_reported) {
+            hl_trace_event *record = hl_aptr(records, hl_trace_event*)[count];
+            if (!record) break;
+            trace_event note;
+            memset(&note, 0, sizeof(note));
+            note.time_ms = now;
+            note.level = TRACE_WARN;
+            note.code = TRACE_EVENTS_DROPPED;
+            note.arg = (int)(dropped - ring->dropped_reported);
+            fill_trace_event(record, &note, now);
+            ring->dropped_reported = dropped;
+            count++;
+        }
+        long long tail = ring->tail;
+        long long head = atomic_load_acquire(&ring->head);
+        while (tail < head && count < max) {
+            hl_trace_event *record = hl_aptr(records, hl_trace_event*)[count];
+            if (!record) break;
+            fill_trace_event(record, &ring->events[tail & TRACE_RING_MASK], now);
+            tail++;
+            count++;
+        }
+        atomic_store_release(&ring->tail, tail);
+    }
+    return count;
+}
+
+// Node pool usage into caller-provided records: one per size class, smallest first, then one
+// for blocks too large to pool (block_size 0). The pool is process-wide and blocks cached in
+// thread caches count as live, so live minus cached is an upper bound on blocks in use.
+// Returns the number of records filled.
+HL_PRIM int HL_NAME(get_pool_stats)(varray *classes) {
+    if (!classes) return 0;
+    int count = classes->size < POOL_CLASS_COUNT + 1 ? classes->size : POOL_CLASS_COUNT + 1;
+    
+    init_process_mutexes(); // May be called before any server exists
+    for (int i = 0; i < count; i++) {
+        hl_pool_stats *stats = hl_aptr(classes, hl_pool_stats*)[i];
+        if (!stats) return i;
+        pool_class *pc = &g_pool[i];
+        stats->block_size = i < POOL_CLASS_COUNT ? 1 << (i + POOL_MIN_SHIFT) : 0;
+        stats->live = (int)atomic_load_acquire(&pc->live);
+        stats->high_water = (int)atomic_load_acquire(&pc->high_water);
+        stats->mallocs = (double)atomic_load_acquire(&pc->mallocs);
+        mutex_lock(&g_pool_mutex);
+        stats->cached = pc->depot_count;
+        mutex_unlock(&g_pool_mutex);
+    }
+    return count;
+}
+
+// Set how many bytes per size class the node pool keeps for reuse once they are freed; blocks
+// beyond that go back to malloc. Size it from get_pool_stats high-water marks. Process-wide.
+HL_PRIM void HL_NAME(set_pool_limit)(int bytes) {
+    if (bytes < 0) return;
+    g_pool_limit = bytes;
+}
+
+// Drain up to max pending WebSocket events into caller-provided records (called from Haxe
+// main thread). Returns the number of records filled.
+HL_PRIM int HL_NAME(poll_websocket_events)(hl_civetweb_server *server, varray *events, int max) {
+    if (!server || !events) return 0;
+    if (max > events->size) max = events->size;
+    
+    int count = 0;
+    while (count < max) {
+        hl_websocket_event *evt = hl_aptr(events, hl_websocket_event*)[count];
+        if (!evt) break;
+        long long pos;
+        ws_ring_cell *cell = claim_websocket_cell(&server->ws_events, &pos);
+        if (!cell) break;
+        fill_websocket_event(evt, cell);
+        release_websocket_cell(cell, pos);
+        count++;
+    }
+    return count;
+}
 
 // Define HashLink bindings
 DEFINE_PRIM(_ABSTRACT(hl_civetweb_server), create, _BYTES _I32 _BYTES);
 DEFINE_PRIM(_BOOL, start, _ABSTRACT(hl_civetweb_server));
 DEFINE_PRIM(_VOID, stop, _ABSTRACT(hl_civetweb_server));
+DEFINE_PRIM(_BOOL, set_option, _ABSTRACT(hl_civetweb_server) _BYTES _BYTES);
+DEFINE_PRIM(_VOID, set_keep_alive, _ABSTRACT(hl_civetweb_server) _BOOL _I32);
+DEFINE_PRIM(_VOID, set_max_body_size, _ABSTRACT(hl_civetweb_server) _I32);
+DEFINE_PRIM(_VOID, set_max_suspended, _ABSTRACT(hl_civetweb_server) _I32);
+DEFINE_PRIM(_I32, get_worker_threads, _ABSTRACT(hl_civetweb_server));
+DEFINE_PRIM(_VOID, set_default_timeout, _ABSTRACT(hl_civetweb_server) _I32);
+DEFINE_PRIM(_BOOL, set_route_timeout, _ABSTRACT(hl_civetweb_server) _BYTES _BYTES _I32);
+DEFINE_PRIM(_VOID, set_max_queue_depth, _ABSTRACT(hl_civetweb_server) _I32);
+DEFINE_PRIM(_BOOL, add_websocket_path, _ABSTRACT(hl_civetweb_server) _BYTES);
+DEFINE_PRIM(_BOOL, add_static_mount, _ABSTRACT(hl_civetweb_server) _BYTES _BYTES _BYTES);
+DEFINE_PRIM(_VOID, set_compression, _ABSTRACT(hl_civetweb_server) _I32 _I32);
+DEFINE_PRIM(_BOOL, add_compressible_type, _ABSTRACT(hl_civetweb_server) _BYTES);
+DEFINE_PRIM(_VOID, set_websocket_accept_timeout, _ABSTRACT(hl_civetweb_server) _I32);
+DEFINE_PRIM(_VOID, set_max_pending_handshakes, _ABSTRACT(hl_civetweb_server) _I32);
 DEFINE_PRIM(_BOOL, is_running, _ABSTRACT(hl_civetweb_server));
 DEFINE_PRIM(_I32, get_port, _ABSTRACT(hl_civetweb_server));
 DEFINE_PRIM(_BYTES, get_host, _ABSTRACT(hl_civetweb_server));
 DEFINE_PRIM(_VOID, free, _ABSTRACT(hl_civetweb_server));
 // Removed deprecated callback setters
-DEFINE_PRIM(_I32, websocket_send, _BYTES _I32 _BYTES _I32);
-DEFINE_PRIM(_VOID, websocket_close, _BYTES _I32 _BYTES);
-DEFINE_PRIM(_DYN, poll_request, _ABSTRACT(hl_civetweb_server));
-DEFINE_PRIM(_VOID, push_response, _ABSTRACT(hl_civetweb_server) _I32 _I32 _BYTES _BYTES _I32);
+DEFINE_PRIM(_I32, websocket_send, _ABSTRACT(hl_civetweb_server) _I32 _I32 _BYTES _I32);
+DEFINE_PRIM(_VOID, websocket_close, _ABSTRACT(hl_civetweb_server) _I32 _I32 _BYTES);
+DEFINE_PRIM(_BOOL, websocket_accept, _ABSTRACT(hl_civetweb_server) _I32 _BOOL);
+DEFINE_PRIM(_I32, websocket_broadcast, _ABSTRACT(hl_civetweb_server) _ARR _I32 _I32 _BYTES _I32);
+DEFINE_PRIM(_BOOL, poll_request, _ABSTRACT(hl_civetweb_server) _REQUEST_RECORD);
+DEFINE_PRIM(_VOID, push_response, _ABSTRACT(hl_civetweb_server) _I32 _I32 _BYTES _BYTES _BYTES _I32);
+DEFINE_PRIM(_I32, poll_requests, _ABSTRACT(hl_civetweb_server) _ARR _I32);
+DEFINE_PRIM(_BOOL, set_islands, _ABSTRACT(hl_civetweb_server) _I32);
+DEFINE_PRIM(_I32, poll_island, _ABSTRACT(hl_civetweb_server) _I32 _ARR _I32 _I32);
+DEFINE_PRIM(_BOOL, wait_for_work, _ABSTRACT(hl_civetweb_server) _I32);
+DEFINE_PRIM(_I32, get_wakeup_fd, _ABSTRACT(hl_civetweb_server));
+DEFINE_PRIM(_VOID, push_responses, _ABSTRACT(hl_civetweb_server) _I32 _ARR _ARR _ARR _ARR _ARR _ARR);
+DEFINE_PRIM(_VOID, get_queue_stats, _ABSTRACT(hl_civetweb_server) _QUEUE_STATS);
+DEFINE_PRIM(_I32, get_stats, _ABSTRACT(hl_civetweb_server) _ARR _BOOL);
+DEFINE_PRIM(_BYTES, get_context_info, _ABSTRACT(hl_civetweb_server));
+DEFINE_PRIM(_BYTES, get_connection_info, _ABSTRACT(hl_civetweb_server) _I32);
+DEFINE_PRIM(_BOOL, suspend_request, _ABSTRACT(hl_civetweb_server) _I32 _I32);
+DEFINE_PRIM(_BOOL, begin_response, _ABSTRACT(hl_civetweb_server) _I32 _I32 _BYTES _BYTES);
+DEFINE_PRIM(_BOOL, push_chunk, _ABSTRACT(hl_civetweb_server) _I32 _BYTES _I32);
+DEFINE_PRIM(_BOOL, end_response, _ABSTRACT(hl_civetweb_server) _I32);
 DEFINE_PRIM(_DYN, poll_websocket_event, _ABSTRACT(hl_civetweb_server));
+DEFINE_PRIM(_I32, poll_websocket_events, _ABSTRACT(hl_civetweb_server) _ARR _I32);
+DEFINE_PRIM(_VOID, set_trace_level, _I32);
+DEFINE_PRIM(_I32, drain_trace, _ARR _I32);
+DEFINE_PRIM(_I32, get_pool_stats, _ARR);
+DEFINE_PRIM(_VOID, set_pool_limit, _I32);
@@ -70,7 +70,7 @@ if not exist "%OUT_DIR%" mkdir "%OUT_DIR%"
 set OUT=%OUT_DIR%\civetweb.hdll
 
 echo Compiling and Linking %OUT%...
-cl /O2 /I "%HL_INCLUDE%" /I . /LD /Fe%OUT% /DNO_SSL /DUSE_WEBSOCKET hl\civetweb_hl.c civetweb.c "%HL_LIB%" /link /DLL /OUT:%OUT%
+cl /O2 /I "%HL_INCLUDE%" /I . /LD /Fe%OUT% /DNO_SSL /DUSE_WEBSOCKET /DUSE_SERVER_STATS /DMG_EXPERIMENTAL_INTERFACES hl\civetweb_hl.c civetweb.c "%HL_LIB%" /link /DLL /OUT:%OUT%
 
 if %ERRORLEVEL% NEQ 0 (
     echo.